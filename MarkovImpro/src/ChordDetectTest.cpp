@@ -1,45 +1,58 @@
 #include "ChordDetector.h"
 #include <iostream>
+#include <vector>
 #include <assert.h>
 
+/** true if the view holds exactly these notes, in this order */
+bool chordIs(ChordDetector::ChordView chord, const std::vector<int>& expected)
+{
+    if (chord.size() != expected.size()) return false;
+    std::size_t i = 0;
+    for (int note : chord){
+        if (note != expected[i++]) return false;
+    }
+    return true;
+}
+
 int main()
 {
     ChordDetector cd {5};
 
-    cd.addNote(25, 100);
-    cd.addNote(25, 101);
-    // 0.1 < 0.5 no chord
+    assert(cd.addNote(60, 100) == false);
+    assert(cd.addNote(64, 101) == false);
+    // 1 <= 5 no chord
     assert(cd.hasChord() == false );
-    // 5 > 0.1 - chord ready
-    cd.addNote(25, 105);
+    // 6 > 5 - chord ready
+    assert(cd.addNote(67, 107) == true);
     assert(cd.hasChord() == true );
-    std::vector<int> chord = cd.getChord();
-    assert(chord.size() == 2);
-    // 5 > 0.1 - 'chord' with one note ready
-    cd.addNote(25, 110);
-    chord = cd.getChord();
-    assert(chord.size() == 1);
-    
-    // now try putting in two chords and checking it wipes 
+    assert(chordIs(cd.getChord(), {60, 64}));
+    // 6 > 5 - 'chord' with one note ready
+    assert(cd.addNote(69, 113) == true);
+    assert(chordIs(cd.getChord(), {67}));
+
+    // now try putting in two chords and checking it wipes
     // the first one
-    cd.addNote(25, 105);
-    cd.addNote(25, 106);
-    
-    cd.addNote(25, 120);
-    // now should have a chord with 2 notes
+    cd.addNote(70, 114);
+    cd.addNote(71, 130);
+    // now should have a chord with 3 notes
     // but - don't ask for it
-    cd.addNote(25, 121);
-    cd.addNote(25, 122);
-    cd.addNote(25, 123);
-    cd.addNote(25, 140);
+    cd.addNote(72, 131);
+    cd.addNote(73, 132);
+    cd.addNote(74, 133);
+    cd.addNote(75, 140);
     // now should have a chord with 4 notes
-    chord = cd.getChord();
-    assert(chord.size() == 4);
-    
-    
+    assert(chordIs(cd.getChord(), {71, 72, 73, 74}));
+
+    // tick holds the last note back until the interval has passed
+    assert(cd.tick(140) == false);
+    assert(cd.tick(145) == false);
+    assert(chordIs(cd.getChord(), {71, 72, 73, 74}));
+    // then lets it out without waiting for another note
+    assert(cd.tick(146) == true);
+    assert(chordIs(cd.getChord(), {75}));
+    // and has nothing left to release
+    assert(cd.tick(200) == false);
+    assert(chordIs(cd.getChord(), {75}));
 
-    
-    
-    
-    
-}
\ No newline at end of file
+    std::cout << "ChordDetectTest passed" << std::endl;
+}
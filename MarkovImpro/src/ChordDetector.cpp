@@ -2,54 +2,54 @@
 
 
 ChordDetector::ChordDetector(unsigned long _maxInterval)
-: maxInterval{_maxInterval}
+: notes{}, noteCount{0}, lastNoteTime{0}, lastChord{}, lastChordSize{0}, maxInterval{_maxInterval}
 {
 
 }
 
-void ChordDetector::addNote(int note, unsigned long time)
+bool ChordDetector::addNote(int note, unsigned long time)
 {
-    std::cout << "ChordDetector::addNote " << maxInterval << " n: " << note << " : " << time << std::endl;
-   // check if we are ready to release a chord
-   // case 1: no notes yet
-   if (notes.size() == 0){
-     std::cout << "no notes" << std::endl;
-    notes.push_back({note, time});
-    return; 
+   // check if we are ready to release a chord:
+   // the note is far enough after the previous one to start a new chord
+   bool released = false;
+   if (noteCount > 0 && time - lastNoteTime > maxInterval){
+    releaseChord();
+    released = true;
    }
-
-   unsigned long timeDiff = time - notes.back().time;
-
-   // case 2: have notes, ready for chord
-   // check distance from previous note
-   if (timeDiff > maxInterval) {// chord time
-    // convert stored notes into a vector and store it
-    lastChord.clear();
-    for (const NoteInfo& info : notes){
-        lastChord.push_back(info.note);
-    }
-    // now add a fresh note
-    notes.clear();
-    notes.push_back({note, time});
-    return; 
-   }
-   // case 3: have notes, not ready for chord
-   if (timeDiff < maxInterval){
-    // just add it to the notes
-    notes.push_back({note, time});
+   // a chord with more notes than there is room for keeps the first ones
+   if (noteCount < notes.size()){
+    notes[noteCount ++] = note;
    }
+   lastNoteTime = time;
+   return released;
+}
 
+bool ChordDetector::tick(unsigned long time)
+{
+   // nothing waiting, or the last note might still have company coming
+   if (noteCount == 0 || time <= lastNoteTime || time - lastNoteTime <= maxInterval){
+    return false;
+   }
+   releaseChord();
+   return true;
 }
 
 bool ChordDetector::hasChord() const 
 {
-   if (lastChord.size() == 0){
+   if (lastChordSize == 0){
     return false; 
    }
    return true; 
 }
 
-std::vector<int> ChordDetector::getChord() const 
+ChordDetector::ChordView ChordDetector::getChord() const 
 {
-    return lastChord; 
-}
\ No newline at end of file
+    return ChordView{lastChord.data(), lastChordSize}; 
+}
+
+void ChordDetector::releaseChord()
+{
+    lastChord = notes;
+    lastChordSize = noteCount;
+    noteCount = 0;
+}
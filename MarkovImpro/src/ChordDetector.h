@@ -1,8 +1,21 @@
-#include <vector> 
-#include <iostream>
+#pragma once
+
+#include <array>
+#include <cstddef>
 
 class ChordDetector{
     public:
+        /** the most notes one chord can hold, any more are dropped */
+        static constexpr std::size_t maxChordNotes = 32;
+        /** a read only view of a chord's notes, in the order they were played */
+        struct ChordView {
+            const int* first;
+            std::size_t count;
+            const int* begin() const { return first; }
+            const int* end() const { return first + count; }
+            std::size_t size() const { return count; }
+            bool empty() const { return count == 0; }
+        };
         /**
          * @brief Construct a new Chord Detector object
          * 
@@ -15,27 +28,41 @@ class ChordDetector{
          * 
          * @param note 
          * @param timeMs 
+         * @return true if this note released a new chord
          */
-        void addNote(int note, unsigned long time);
+        bool addNote(int note, unsigned long time);
+        /**
+         * @brief Release the notes waiting to become a chord once maxInterval has passed since the last of them,
+         * so the last chord of a phrase comes out without waiting for another note. Call it once per block
+         * 
+         * @param time: now, in the same units as addNote
+         * @return true if this released a new chord
+         */
+        bool tick(unsigned long time);
         /**
          * @brief Does it have a chord ready? 
          * 
-         * @return true if last two notes are at least maxInterval apart 
-         * @return false if last two notes are less than maxInterval or not enough notes yet (0 or 1)
+         * @return true if a chord has been released
+         * @return false if not enough notes yet (0 or 1)
          */
         bool hasChord() const;
         /**
          * @brief get the last detected chord. every time a new chord comes in, it wipes the old one
          * 
-         * @return std::vector<int> which might be empty if 'hasChord == false
+         * @return a view of the chord, which might be empty if 'hasChord == false. 
+         * It stays valid until the next chord is released
          */
-        std::vector<int> getChord() const;
+        ChordView getChord() const;
     private:
-        struct NoteInfo {int note; 
-                         unsigned long time;
-                         };
-        std::vector<NoteInfo> notes; 
-        std::vector<int> lastChord; 
+        /** moves the waiting notes into lastChord */
+        void releaseChord();
+
+        std::array<int, maxChordNotes> notes; 
+        std::size_t noteCount;
+        /** when the last waiting note came in */
+        unsigned long lastNoteTime;
+        std::array<int, maxChordNotes> lastChord; 
+        std::size_t lastChordSize;
         unsigned long maxInterval;
 
-};
\ No newline at end of file
+};
@@ -12,7 +12,10 @@
 //==============================================================================
 MidiMarkovEditor::MidiMarkovEditor (MidiMarkovProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p), 
-    miniPianoKbd{kbdState, juce::MidiKeyboardComponent::horizontalKeyboard} 
+    miniPianoKbd{kbdState, juce::MidiKeyboardComponent::horizontalKeyboard},
+    learnAttachment{p.parameters, MidiMarkovProcessor::learnParameterID, onOffButton},
+    generateAttachment{p.parameters, MidiMarkovProcessor::generateParameterID, genButton},
+    randomnessAttachment{p.parameters, MidiMarkovProcessor::randomnessParameterID, randomnessSlider}
 
 {    
 
@@ -38,13 +41,32 @@ MidiMarkovEditor::MidiMarkovEditor (MidiMarkovProcessor& p)
     onOffButton.setButtonText("Learning On/Off");
     onOffButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::lightgreen);
     onOffButton.setColour(juce::ToggleButton::tickDisabledColourId, juce::Colours::darkgrey);
-    onOffButton.addListener(this);
 
     addAndMakeVisible(genButton);
     genButton.setButtonText("Generation On/Off");
     genButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::lightgreen);
     genButton.setColour(juce::ToggleButton::tickDisabledColourId, juce::Colours::darkgrey);
-    genButton.addListener(this);
+
+    addAndMakeVisible(relativePitchButton);
+    relativePitchButton.setButtonText("Relative Pitch");
+    relativePitchButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::lightgreen);
+    relativePitchButton.setColour(juce::ToggleButton::tickDisabledColourId, juce::Colours::darkgrey);
+    relativePitchButton.setToggleState(audioProcessor.getRelativePitch(), juce::dontSendNotification);
+    relativePitchButton.addListener(this);
+
+    addAndMakeVisible(allKeysButton);
+    allKeysButton.setButtonText("All Keys");
+    allKeysButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::lightgreen);
+    allKeysButton.setColour(juce::ToggleButton::tickDisabledColourId, juce::Colours::darkgrey);
+    allKeysButton.setToggleState(audioProcessor.getTranspositionAugmentation(), juce::dontSendNotification);
+    allKeysButton.addListener(this);
+
+    addAndMakeVisible(tempoGridButton);
+    tempoGridButton.setButtonText("Tempo Grid");
+    tempoGridButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::lightgreen);
+    tempoGridButton.setColour(juce::ToggleButton::tickDisabledColourId, juce::Colours::darkgrey);
+    tempoGridButton.setToggleState(audioProcessor.getTimeQuantisation() == TimeQuantiser::Mode::tempoGrid, juce::dontSendNotification);
+    tempoGridButton.addListener(this);
 
     addAndMakeVisible(saveButton);
     //saveButton.setColour(juce::TextButton::buttonColourId, juce::Colours::darkblue);
@@ -68,19 +90,24 @@ MidiMarkovEditor::MidiMarkovEditor (MidiMarkovProcessor& p)
     randomnessSlider.setColour(juce::Slider::thumbColourId, juce::Colours::lightblue);
     randomnessSlider.setColour(juce::Slider::trackColourId, juce::Colours::darkblue);
     randomnessSlider.setColour(juce::Slider::textBoxTextColourId, juce::Colours::white);
-    randomnessSlider.setRange(0.0, 100.0, 0.1);
     randomnessSlider.setTextValueSuffix("% Randomness");
-    randomnessSlider.addListener(this);
     addAndMakeVisible(randomnessSlider);    
 
     dynamicTextLabel.setText("Detected Key: ", juce::dontSendNotification);
     dynamicTextLabel.setFont(juce::Font(24.0f).boldened());
     dynamicTextLabel.setJustificationType(juce::Justification::left);
     addAndMakeVisible(dynamicTextLabel);
+
+    statusLabel.setJustificationType(juce::Justification::left);
+    addAndMakeVisible(statusLabel);
+    // the processor's status is read here rather than pushed from the audio thread
+    showStatus(audioProcessor.status.read());
+    startTimerHz(15);
 }
 
 MidiMarkovEditor::~MidiMarkovEditor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -105,32 +132,23 @@ void MidiMarkovEditor::resized()
 
     miniPianoKbd.setBounds(0, rowHeight*row, getWidth(), rowHeight);
     row ++ ; 
-    resetButton.setBounds(0, rowHeight*row, getWidth(), rowHeight);
+    resetButton.setBounds(0, rowHeight*row, getWidth()/2 - 1, rowHeight);
+    relativePitchButton.setBounds(getWidth()/2, rowHeight*row, getWidth()/2, rowHeight);
     row ++;
-    saveButton.setBounds(0, rowHeight*row, getWidth()/2 - 1, rowHeight);
-    loadButton.setBounds(getWidth()/2, rowHeight*row, getWidth()/2, rowHeight);
+    saveButton.setBounds(0, rowHeight*row, getWidth()/3 - 1, rowHeight);
+    loadButton.setBounds(getWidth()/3, rowHeight*row, getWidth()/3 - 1, rowHeight);
+    tempoGridButton.setBounds(2*getWidth()/3, rowHeight*row, getWidth()/3, rowHeight);
     row ++;
     randomnessSlider.setBounds(0, rowHeight*row+5, getWidth(), rowHeight);
     row++;
     onOffButton.setBounds(0, rowHeight*row, getWidth()/5, rowHeight-1);
-    dynamicTextLabel.setBounds(getWidth()/3, rowHeight*row, 2*colWidth, 2*rowHeight);
+    dynamicTextLabel.setBounds(getWidth()/3, rowHeight*row, 2*colWidth, rowHeight);
+    statusLabel.setBounds(getWidth()/3, rowHeight*(row+1), 2*colWidth, rowHeight);
     row ++;
     genButton.setBounds(0, rowHeight*row-10, getWidth()/5, rowHeight);
+    allKeysButton.setBounds(getWidth()/5, rowHeight*row-10, getWidth()/3 - getWidth()/5, rowHeight);
     
     
-}
-
- void MidiMarkovEditor::sliderValueChanged (juce::Slider *slider)
-{
-    
-    if (slider == &randomnessSlider)
-    {
-        audioProcessor.pitchModel.chain.randomness = (slider->getValue()) / 100;
-        audioProcessor.iOIModel.chain.randomness = (slider->getValue()) / 100;
-        audioProcessor.noteDurationModel.chain.randomness = (slider->getValue()) / 100;
-        audioProcessor.velocityModel.chain.randomness = (slider->getValue()) / 100;
-    }
-    
 }
 
 void MidiMarkovEditor::buttonClicked(juce::Button* btn)
@@ -138,11 +156,14 @@ void MidiMarkovEditor::buttonClicked(juce::Button* btn)
     if (btn == &resetButton){
         audioProcessor.resetMarkovModel();
     }
-    else if (btn == &onOffButton) {
-        audioProcessor.learnOn = onOffButton.getToggleState();
+    else if (btn == &relativePitchButton) {
+        audioProcessor.setRelativePitch(relativePitchButton.getToggleState());
+    }
+    else if (btn == &allKeysButton) {
+        audioProcessor.setTranspositionAugmentation(allKeysButton.getToggleState());
     }
-    else if (btn == &genButton) {
-        audioProcessor.canGenerateNotes = genButton.getToggleState();
+    else if (btn == &tempoGridButton) {
+        audioProcessor.setTimeQuantisation(tempoGridButton.getToggleState() ? TimeQuantiser::Mode::tempoGrid : TimeQuantiser::Mode::logarithmic);
     }
     else if (btn == &saveButton)
     {
@@ -158,13 +179,25 @@ void MidiMarkovEditor::buttonClicked(juce::Button* btn)
         if (chooser.browseForFileToOpen()) {
             juce::File file = chooser.getResult();
             audioProcessor.loadMarkovModel(file);
+            relativePitchButton.setToggleState(audioProcessor.getRelativePitch(), juce::dontSendNotification);
+            tempoGridButton.setToggleState(audioProcessor.getTimeQuantisation() == TimeQuantiser::Mode::tempoGrid, juce::dontSendNotification);
         }
     }
 }
 
-void MidiMarkovEditor::updateDynamicText(juce::String& key)
+void MidiMarkovEditor::timerCallback()
+{
+    PluginStatus::Snapshot latest = audioProcessor.status.read();
+    if (latest != shownStatus) showStatus(latest);
+}
+
+void MidiMarkovEditor::showStatus(const PluginStatus::Snapshot& latest)
 {
-    dynamicTextLabel.setText("Detected Key: " + key, juce::dontSendNotification);
+    shownStatus = latest;
+    dynamicTextLabel.setText(juce::String("Detected Key: ") + ScaleTables::keyName(latest.key), juce::dontSendNotification);
+    statusLabel.setText(juce::String(latest.contexts) + " contexts, last match order " + juce::String(latest.lastOrder) +
+                        ", " + juce::String(latest.eventsLearnt) + " chords learnt, " +
+                        juce::String(latest.notesGenerated) + " notes played", juce::dontSendNotification);
 }
 
 void MidiMarkovEditor::handleNoteOn(juce::MidiKeyboardState *source, int midiChannel, int midiNoteNumber, float velocity)
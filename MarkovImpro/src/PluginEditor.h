@@ -20,10 +20,10 @@
 class MidiMarkovEditor  :   public juce::AudioProcessorEditor,
                           // listen to buttons
                           public juce::Button::Listener, 
-                          // listen to sliders
-                          public juce::Slider::Listener, 
                           // listen to piano keyboard widget
-                          private juce::MidiKeyboardState::Listener
+                          private juce::MidiKeyboardState::Listener,
+                          // poll the processor's status
+                          private juce::Timer
 
 {
 public:
@@ -34,9 +34,7 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
-    void sliderValueChanged (juce::Slider *slider) override;
     void buttonClicked(juce::Button* btn) override;
-    void updateDynamicText(juce::String& key);
     // from MidiKeyboardState
     void handleNoteOn(juce::MidiKeyboardState *source, int midiChannel, int midiNoteNumber, float
  velocity) override; 
@@ -45,6 +43,9 @@ public:
 
 
 private:
+    /** shows what the processor last published, if it has changed since the last look */
+    void timerCallback() override;
+    void showStatus(const PluginStatus::Snapshot& latest);
 
     // needed for the mini piano keyboard
     juce::MidiKeyboardState kbdState;
@@ -53,6 +54,9 @@ private:
     
     juce::ToggleButton onOffButton;
     juce::ToggleButton genButton;
+    juce::ToggleButton relativePitchButton;
+    juce::ToggleButton allKeysButton;
+    juce::ToggleButton tempoGridButton;
 
     juce::TextButton saveButton;
     juce::TextButton loadButton;
@@ -60,10 +64,18 @@ private:
     juce::Slider randomnessSlider;
 
     juce::Label dynamicTextLabel;
+    juce::Label statusLabel;
+    /** what the labels show now */
+    PluginStatus::Snapshot shownStatus;
 
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     MidiMarkovProcessor& audioProcessor;
 
+    /** keep the controls and the processor's parameters in step, and go before the controls do */
+    juce::AudioProcessorValueTreeState::ButtonAttachment learnAttachment;
+    juce::AudioProcessorValueTreeState::ButtonAttachment generateAttachment;
+    juce::AudioProcessorValueTreeState::SliderAttachment randomnessAttachment;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiMarkovEditor)
 };
@@ -26,55 +26,41 @@ MidiMarkovProcessor::MidiMarkovProcessor()
                          )
 #endif
       ,
-      pitchModel{}, iOIModel{}, velocityModel{}, lastNoteOnTime{0}, elapsedSamples{0}, modelPlayNoteTime{0}, noMidiYet{true}, chordDetect{0}
-{
-  // set all note off times to zero 
-
-  for (auto i=0;i<127;++i){
-    noteOffTimes[i] = 0;
+      eventModel{}, parameters{*this, nullptr, "PARAMETERS", createParameterLayout()},
+      learnParameter{parameters.getRawParameterValue(learnParameterID)},
+      generateParameter{parameters.getRawParameterValue(generateParameterID)},
+      randomnessParameter{parameters.getRawParameterValue(randomnessParameterID)},
+      lastNoteOnTime{0}, elapsedSamples{0}, modelPlayNoteTime{0}, noMidiYet{true}, chordDetect{0}
+{
+  // past order 8 contexts are nearly all one-offs, so they go into a fixed size sketch
+  eventModel.setExactOrderLimit(exactOrders);
+  // whole events rarely repeat exactly, so let pitch match on its own
+  eventModel.setFactorisedBackoff(true);
+  // the audio thread logs through a ring, which this writes out to stderr
+  RealtimeLog::global().start();
+
+  for (auto i=0;i<128;++i){
     noteOnTimes[i] = 0;
-}   
-   
-    for (int i = 0; i < 75; i++) {
-        CMinor[i] = DSharpMajor[i];
-    }
-    for (int i = 0; i < std::size(EMajor)-1; i++) {
-        CSharpMinor[i] = EMajor[i];
-    }
-    for (int i = 0; i < std::size(FMajor)-1; i++) {
-        DMinor[i] = FMajor[i];
-    }
-    for (int i = 0; i < std::size(FSharpMajor)-1; i++) {
-        DSharpMinor[i] = FSharpMajor[i];
-    }
-    for (int i = 0; i < std::size(GMajor)-1; i++) {
-        EMinor[i] = GMajor[i];
-    }
-    for (int i = 0; i < std::size(GSharpMajor)-1; i++) {
-        FMinor[i] = GSharpMajor[i];
-    }
-    for (int i = 0; i < std::size(AMajor)-1; i++) {
-        FSharpMinor[i] = AMajor[i];
-    }
-    for (int i = 0; i < std::size(ASharpMajor)-1; i++) {
-        GMinor[i] = ASharpMajor[i];
-    }
-    for (int i = 0; i < std::size(BMajor)-1; i++) {
-        GSharpMinor[i] = BMajor[i];
-    }
-    for (int i = 0; i < std::size(CMajor)-1; i++) {
-        AMinor[i] = CMajor[i];
-    }
-    for (int i = 0; i < std::size(CSharpMajor)-1; i++) {
-        ASharpMinor[i] = CSharpMajor[i];
-    }
-    for (int i = 0; i < std::size(DMajor)-1; i++) {
-        BMinor[i] = DMajor[i];
-    }
+    noteOnVelocities[i] = 0;
+    noteLengths[i] = 0;
+  }
 }
 
 MidiMarkovProcessor::~MidiMarkovProcessor()
 {
+  // the last instance to go stops the log's thread, before the host unloads the plugin
+  RealtimeLog::global().stop();
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout MidiMarkovProcessor::createParameterLayout()
+{
+  juce::AudioProcessorValueTreeState::ParameterLayout layout;
+  layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{learnParameterID, 1}, "Learning", false));
+  layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{generateParameterID, 1}, "Generation", false));
+  layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{randomnessParameterID, 1}, "Randomness",
+                                                         juce::NormalisableRange<float>{0.0f, 100.0f, 0.1f}, 0.0f,
+                                                         juce::AudioParameterFloatAttributes{}.withLabel("%")));
+  return layout;
 }
 
 //==============================================================================
@@ -144,6 +130,16 @@ void MidiMarkovProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
   double maxIntervalInSamples = sampleRate * 0.05; // 50ms
   chordDetect = ChordDetector((unsigned long) maxIntervalInSamples); 
+  iOIQuantiser.setSampleRate(sampleRate);
+  durationQuantiser.setSampleRate(sampleRate);
+  keyDetector.setSampleRate(sampleRate);
+  // preallocate the model storage here so that training 
+  // in processBlock does not hit the system allocator
+  eventModel.reserveMemory(JointEventModel::memoryFor(reservedEvents, exactOrders));
+  // and the generated messages, so that generating does not either
+  generatedMessages.ensureSize(generatedMessagesBytes);
+  randomness.reset(sampleRate, 0.05);
+  randomness.setCurrentAndTargetValue(randomnessParameter->load());
 }
 
 void MidiMarkovProcessor::releaseResources()
@@ -177,12 +173,15 @@ bool MidiMarkovProcessor::isBusesLayoutSupported(const BusesLayout &layouts) con
 }
 #endif
 
-void MidiMarkovProcessor::updateEditorDisplay(juce::String& key)
+void MidiMarkovProcessor::publishStatus()
 {
-    if (auto* editor = dynamic_cast<MidiMarkovEditor*>(getActiveEditor()))
-    {
-        editor->updateDynamicText(key);
-    }
+  PluginStatus::Snapshot snapshot;
+  snapshot.key = maxIndex;
+  snapshot.contexts = eventModel.size();
+  snapshot.lastOrder = eventModel.getOrderOfLastEvent();
+  snapshot.eventsLearnt = eventsLearnt;
+  snapshot.notesGenerated = notesGenerated;
+  status.publish(snapshot);
 }
 
 void MidiMarkovProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages)
@@ -195,10 +194,29 @@ void MidiMarkovProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::M
   // which the UI might call to send notes from the piano widget
   if (!keyLoaded)
     { 
-      analyzeKey(200);
+      updateDetectedKey();
       keyLoaded = true;
     }
   
+  // read the parameters once, so the whole block sees the same values
+  const bool learning = learnParameter->load(std::memory_order_relaxed) >= 0.5f;
+  const bool generating = generateParameter->load(std::memory_order_relaxed) >= 0.5f;
+  randomness.setTargetValue(randomnessParameter->load(std::memory_order_relaxed));
+  randomness.skip(buffer.getNumSamples());
+
+  // follow the host tempo for the tempo grid
+  if (auto* playHead = getPlayHead())
+  {
+    if (auto position = playHead->getPosition())
+    {
+      if (auto bpm = position->getBpm())
+      {
+        iOIQuantiser.setTempo(*bpm);
+        durationQuantiser.setTempo(*bpm);
+      }
+    }
+  }
+
   if (midiToProcess.getNumEvents() > 0)
   {
     midiMessages.addEvents(midiToProcess, midiToProcess.getFirstEventTime(), midiToProcess.getLastEventTime() + 1, 0);
@@ -206,43 +224,29 @@ void MidiMarkovProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::M
   }
   
     
-  if (learnOn){
-    for (const auto metadata : midiMessages)
-      {
-          auto message = metadata.getMessage();
-          if (message.isNoteOn())
-          {
-              int noteNumber = message.getNoteNumber();
-              analyzeKey(noteNumber);
-              // Use noteNumber as needed
-          }
-      }
-    analysePitches(midiMessages);
-    analyseDuration(midiMessages);
-    analyseIoI(midiMessages);
-    analyseVelocity(midiMessages);
+  if (learning){
+    analyseBlock(midiMessages);
+    // the last chord of a phrase has no next note to end it
+    unsigned long blockEnd = elapsedSamples + buffer.getNumSamples();
+    if (chordDetect.tick(blockEnd)) takeChord(blockEnd);
   }
-  juce::MidiBuffer generatedMessages;
-  if (canGenerateNotes){
-    generatedMessages = generateNotesFromModel(midiMessages);
-  }
-  // send note offs if needed  
-  for (auto i = 0; i < 127; ++i)
-  {
-    if (noteOffTimes[i] > 0 &&
-        noteOffTimes[i] < elapsedSamples)
-    {
-      juce::MidiMessage nOff = juce::MidiMessage::noteOff(1, i, 0.0f);
-      generatedMessages.addEvent(nOff, 0);
-      noteOffTimes[i] = 0;
-    }
+  // anything the model was too busy to take last time
+  trainPendingEvents();
+  // keeps the storage it grew to in earlier blocks
+  generatedMessages.clear();
+  if (generating){
+    generateNotesFromModel(buffer.getNumSamples());
   }
+  // send the rest of the note offs that fall in this block, where they fall
+  sendDueNoteOffs(generatedMessages, elapsedSamples + buffer.getNumSamples());
   // now you can clear the outgoing buffer if you want
   midiMessages.clear();
   // then add your generated messages
   midiMessages.addEvents(generatedMessages, generatedMessages.getFirstEventTime(), -1, 0);
 
   elapsedSamples += buffer.getNumSamples();
+  // the editor picks this up on its timer
+  publishStatus();
 }
 
 //==============================================================================
@@ -259,15 +263,16 @@ juce::AudioProcessorEditor *MidiMarkovProcessor::createEditor()
 //==============================================================================
 void MidiMarkovProcessor::getStateInformation(juce::MemoryBlock &destData)
 {
-  // You should use this method to store your parameters in the memory block.
-  // You could do that either as raw data, or use the XML or ValueTree classes
-  // as intermediaries to make it easy to save and load complex data.
+  // the parameters only, the model is saved and loaded from the editor
+  if (auto xml = parameters.copyState().createXml())
+    copyXmlToBinary(*xml, destData);
 }
 
 void MidiMarkovProcessor::setStateInformation(const void *data, int sizeInBytes)
 {
-  // You should use this method to restore your parameters from this memory block,
-  // whose contents will have been created by the getStateInformation() call.
+  auto xml = getXmlFromBinary(data, sizeInBytes);
+  if (xml != nullptr && xml->hasTagName(parameters.state.getType()))
+    parameters.replaceState(juce::ValueTree::fromXml(*xml));
 }
 
 //==============================================================================
@@ -284,407 +289,313 @@ void MidiMarkovProcessor::addMidi(const juce::MidiMessage& msg, int sampleOffset
 
 void MidiMarkovProcessor::resetMarkovModel()
 {
-  pitchModel.reset();
-  iOIModel.reset();
-  noteDurationModel.reset();
-  velocityModel.reset();
-  key = "";
-  newKey = "";
-  for (int i =0; i<24; i++){
-    keyProbs[i] = 0;
-  }
-  updateEditorDisplay(key);
+  // processBlock feeds the key detector and reads the rest
+  ScopedSuspend suspend{*this};
+  // or the workers would carry on training the old model
+  augmenter.flush();
+  eventModel.reset();
+  pendingCount = 0;
+  pitchEncoder.reset();
+  iOIQuantiser.reset();
+  durationQuantiser.reset();
+  nextEvent = NoteEvent{};
+  lastIOIBin = 0;
+  keyDetector.reset();
+  maxIndex = -1;
 }
 
-void MidiMarkovProcessor::analyseIoI(const juce::MidiBuffer& midiMessages)
+void MidiMarkovProcessor::setRelativePitch(bool relative)
 {
-  // compute the IOI 
-  for (const auto metadata : midiMessages){
-      auto message = metadata.getMessage();
-      if (message.isNoteOn()){   
-          unsigned long exactNoteOnTime = elapsedSamples + message.getTimeStamp();
-          unsigned long iOI = exactNoteOnTime - lastNoteOnTime;
-          if (iOI < getSampleRate() * 2 && 
-              iOI > getSampleRate() * 0.05){
-            iOIModel.putEvent(std::to_string(iOI));
-            // DBG("Note on at: " << exactNoteOnTime << " IOI " << iOI);
+  if (relative == relativePitchOn) return;
+  // processBlock encodes and decodes with these
+  ScopedSuspend suspend{*this};
+  relativePitchOn = relative;
+  augmenter.flush();
+  eventModel.reset();
+  pendingCount = 0;
+  pitchEncoder.reset();
+  nextEvent = NoteEvent{};
+}
 
-          }
-          lastNoteOnTime = exactNoteOnTime; 
-      }
+bool MidiMarkovProcessor::getRelativePitch()
+{
+  return relativePitchOn;
+}
+
+void MidiMarkovProcessor::setTimeQuantisation(TimeQuantiser::Mode mode)
+{
+  if (mode == iOIQuantiser.getMode()) return;
+  // processBlock quantises with these, and setMode rebuilds their bins
+  ScopedSuspend suspend{*this};
+  iOIQuantiser.setMode(mode);
+  durationQuantiser.setMode(mode);
+  augmenter.flush();
+  eventModel.reset();
+  pendingCount = 0;
+  nextEvent = NoteEvent{};
+  lastIOIBin = 0;
+}
+
+TimeQuantiser::Mode MidiMarkovProcessor::getTimeQuantisation()
+{
+  return iOIQuantiser.getMode();
+}
+
+void MidiMarkovProcessor::setTranspositionAugmentation(bool augment)
+{
+  augmentOn = augment;
+}
+
+bool MidiMarkovProcessor::getTranspositionAugmentation()
+{
+  return augmentOn;
+}
+
+void MidiMarkovProcessor::setModelEngine(ModelEngine engine)
+{
+  // processBlock writes nextEvent too. the pending events carry over to the new engine
+  ScopedSuspend suspend{*this};
+  augmenter.flush();
+  eventModel.setEngine(engine);
+  nextEvent = NoteEvent{};
+}
+
+ModelEngine MidiMarkovProcessor::getModelEngine()
+{
+  return eventModel.getEngine();
+}
+
+void MidiMarkovProcessor::setKeyWindow(double seconds)
+{
+  ScopedSuspend suspend{*this};
+  keyDetector.setWindow(seconds);
+}
+
+double MidiMarkovProcessor::getKeyWindow()
+{
+  return keyDetector.getWindow();
+}
+
+/** how the engine is written in saved models */
+static juce::String engineName(ModelEngine engine)
+{
+  switch (engine)
+  {
+    case ModelEngine::suffixAutomaton: return "suffixAutomaton";
+    case ModelEngine::denseMatrix: return "denseMatrix";
+    default: return "markovChain";
   }
 }
-    
-void MidiMarkovProcessor::analysePitches(const juce::MidiBuffer& midiMessages)
+
+static ModelEngine engineFromName(const juce::String& name)
 {
+  if (name == "suffixAutomaton") return ModelEngine::suffixAutomaton;
+  if (name == "denseMatrix") return ModelEngine::denseMatrix;
+  return ModelEngine::markovChain;
+}
+
+void MidiMarkovProcessor::analyseBlock(const juce::MidiBuffer& midiMessages)
+{
+  std::size_t count = 0;
+  bool anyNoteOn = false;
   for (const auto metadata : midiMessages)
   {
-    auto message = metadata.getMessage();
-    if (message.isNoteOn()){
-      chordDetect.addNote(
-            message.getNoteNumber(), 
-            // add the offset within this buffer
-            elapsedSamples + message.getTimeStamp()
-        );
-      if (chordDetect.hasChord()){
-          std::string notes = 
-              MidiMarkovProcessor::notesToMarkovState(
-                  chordDetect.getChord()
-              );
-          DBG("Got notes from detector " << notes);
-          pitchModel.putEvent(notes);
-      }     
-      noMidiYet = false;// bootstrap code
+    // read the bytes in place rather than building a MidiMessage for each event
+    if (metadata.numBytes < 3) continue;
+    const juce::uint8 status = metadata.data[0] & 0xf0;
+    if (status != 0x90 && status != 0x80) continue;
+    DecodedNote& decoded = decodedNotes[count];
+    // add the offset within this buffer
+    decoded.time = elapsedSamples + metadata.samplePosition;
+    decoded.note = metadata.data[1] & 0x7f;
+    decoded.velocity = metadata.data[2] & 0x7f;
+    // a note on with no velocity is a note off
+    decoded.isOn = status == 0x90 && decoded.velocity > 0;
+    if (++count == decodedNotes.size())
+    {
+      if (dispatchNotes(count)) anyNoteOn = true;
+      count = 0;
     }
   }
+  if (count > 0 && dispatchNotes(count)) anyNoteOn = true;
+  // the key only needs picking once for the whole block
+  if (anyNoteOn) updateDetectedKey();
 }
 
-void MidiMarkovProcessor::analyseDuration(const juce::MidiBuffer& midiMessages)
+bool MidiMarkovProcessor::dispatchNotes(std::size_t count)
 {
-  for (const auto metadata : midiMessages)
+  bool anyNoteOn = false;
+  for (std::size_t i = 0; i < count; ++i)
   {
-    auto message = metadata.getMessage();
-    if (message.isNoteOn())
-    {
-      noteOnTimes[message.getNoteNumber()] = elapsedSamples + message.getTimeStamp();
+    if (!decodedNotes[i].isOn) continue;
+    keyDetector.addNote(decodedNotes[i].note, decodedNotes[i].time);
+    anyNoteOn = true;
+  }
+  analyseEvents(decodedNotes.data(), count);
+  return anyNoteOn;
+}
+
+void MidiMarkovProcessor::analyseEvents(const DecodedNote* notes, std::size_t count)
+{
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const DecodedNote& decoded = notes[i];
+    if (decoded.isOn){
+      // the chord waiting on its bass was still held, so it lasted until now
+      if (!heldChord.empty()) {
+        learnChord(heldChord, decoded.time);
+        heldChord = PitchSet{};
+      }
+      // a note far enough after the last one ends the chord before it
+      if (chordDetect.addNote(decoded.note, decoded.time)){
+          takeChord(decoded.time);
+      }
+      noteOnTimes[decoded.note] = decoded.time;
+      noteOnVelocities[decoded.note] = decoded.velocity;
+      noteLengths[decoded.note] = 0;
+      noMidiYet = false;// bootstrap code
     }
-    if (message.isNoteOff()){
-      unsigned long noteOffTime = elapsedSamples + message.getTimeStamp();
-      unsigned long noteLength = noteOffTime - 
-                                  noteOnTimes[message.getNoteNumber()];
-      noteDurationModel.putEvent(std::to_string(noteLength));
+    else {
+      noteLengths[decoded.note] = decoded.time - noteOnTimes[decoded.note];
+      if (heldChord.lowest() == decoded.note) {
+        learnChord(heldChord, decoded.time);
+        heldChord = PitchSet{};
+      }
     }
   }
 }
 
+void MidiMarkovProcessor::takeChord(unsigned long now)
+{
+  PitchSet chord{};
+  for (int note : chordDetect.getChord()) chord.add(note);
+  int bass = chord.lowest();
+  if (bass == -1) return;
+  // its length is only known once the bass has been let go
+  if (noteLengths[bass] > 0) learnChord(chord, now);
+  else heldChord = chord;
+}
+
+void MidiMarkovProcessor::learnChord(const PitchSet& chord, unsigned long now)
+{
+  if (chord.empty()) return;
+  // the chord takes its timing and dynamics from its bass note
+  int bass = chord.lowest();
+  unsigned long onset = noteOnTimes[bass];
+  // still held when the next chord came in, so it lasted until then
+  unsigned long length = noteLengths[bass] > 0 ? noteLengths[bass] : now - onset;
+  unsigned long iOI = lastNoteOnTime > 0 ? onset - lastNoteOnTime : 0;
+  // keep gaps between phrases and accidental flams out of the timing:
+  // the chord takes the last IOI that was in range, or the blank before there is one
+  if (iOI > getSampleRate() * 0.05 && iOI < getSampleRate() * 2)
+    lastIOIBin = (std::uint8_t) iOIQuantiser.quantise(iOI);
+  NoteEvent event{};
+  event.pitches = relativePitchOn ? pitchEncoder.encode(chord) : chord;
+  event.iOI = lastIOIBin;
+  event.duration = (std::uint8_t) durationQuantiser.quantise(length);
+  event.velocity = noteOnVelocities[bass];
+  // the workers may have the model, so it waits its turn rather than blocking the block
+  if (pendingCount == maxPendingEvents)
+  {
+    MARKOV_LOG(warning, "MidiMarkovProcessor model busy for too long, chord not learnt", 1000);
+  }
+  else
+  {
+    pendingEvents[(pendingStart + pendingCount) % maxPendingEvents] = event;
+    pendingCount ++;
+  }
+  trainPendingEvents();
+  // only queues the event, the workers do the training
+  if (augmentOn && !relativePitchOn && !augmenter.push(event))
+    MARKOV_LOG(warning, "MidiMarkovProcessor transposition queue full, event not augmented", 1000);
+  lastNoteOnTime = onset;
+}
 
-void MidiMarkovProcessor::analyseVelocity(const juce::MidiBuffer& midiMessages)
+void MidiMarkovProcessor::trainPendingEvents()
 {
-  // compute the IOI 
-  for (const auto metadata : midiMessages){
-      auto message = metadata.getMessage();
-      if (message.isNoteOn()){   
-          auto velocity = message.getVelocity();
-          
-          velocityModel.putEvent(std::to_string(velocity));
-      }
+  while (pendingCount > 0 && eventModel.tryPutEvent(pendingEvents[pendingStart]))
+  {
+    pendingStart = (pendingStart + 1) % maxPendingEvents;
+    pendingCount --;
+    eventsLearnt ++;
   }
 }
 
-juce::MidiBuffer MidiMarkovProcessor::generateNotesFromModel(const juce::MidiBuffer& incomingNotes)
+NoteEvent MidiMarkovProcessor::drawEvent()
 {
+  // if the workers have the model, play nothing now and draw again shortly
+  NoteEvent event{};
+  if (!eventModel.tryGetEvent(event)) return NoteEvent{};
+  if (relativePitchOn) event.pitches = pitchEncoder.decode(event.pitches);
+  return event;
+}
 
-  juce::MidiBuffer generatedMessages{};
-  if (isTimeToPlayNote(elapsedSamples)){
+void MidiMarkovProcessor::generateNotesFromModel(int numSamples)
+{
+  unsigned long lastSample = elapsedSamples + numSamples - 1;
+  // walk through the block, as several events can fall in one
+  while (numSamples > 0 && isTimeToPlayNote(lastSample)){
+    // late if it fell in a block where generation was off, so play it straight away
+    unsigned long playTime = std::max(modelPlayNoteTime, elapsedSamples);
+    int offset = (int) (playTime - elapsedSamples);
+    // offs up to now go first, so they don't cut off the notes played now
+    sendDueNoteOffs(generatedMessages, playTime + 1);
     if (!noMidiYet){ // not in bootstrapping phase 
-      std::string notes = pitchModel.getEvent();
-      unsigned long duration = std::stoul(noteDurationModel.getEvent(true));
-      juce::uint8 velocity = std::stoi(velocityModel.getEvent(true));
-      std::random_device rd;
-      std::mt19937 gen(rd());
-      std::uniform_real_distribution<> dis(0.0, 1.0);
-      for (int& note : markovStateToNotes(notes)){
-          float randChoice = dis(gen);
-          float positiveChoice = dis(gen);
-          float intervalChoice = dis(gen);
+      // nothing was drawn when the last event was played, e.g. the model was empty
+      if (nextEvent.pitches.empty()) nextEvent = drawEvent();
+      PitchSet notes = nextEvent.pitches;
+      unsigned long duration = durationQuantiser.dequantise(nextEvent.duration);
+      juce::uint8 velocity = nextEvent.velocity;
+      for (int note : notes){
+          float randChoice = unitRandom(randomGenerator);
+          float positiveChoice = unitRandom(randomGenerator);
+          float intervalChoice = unitRandom(randomGenerator);
           int chosenNote = note;
-          float randNess = pitchModel.getRandomness();
-          std::array<int, 33> keyIntervals;
-          std::array<int, 75> keyNotes;
+          float randNess = randomness.getCurrentValue() / 100.0f;
           if (maxIndex != -1){
           if (randChoice < randNess)
             {
-              if (positiveChoice > 0.5)
-              {
-                if (intervalChoice >= 0 && intervalChoice < 0.5)
-                  {
-                    int skips = rand() % 4;
-                    switch (maxIndex) {
-                      case 0: std::copy(std::begin(CMajorIntervals), std::end(CMajorIntervals), std::begin(keyIntervals)); break;
-                      case 1: std::copy(std::begin(CSharpMajorIntervals), std::end(CSharpMajorIntervals), std::begin(keyIntervals)); break;
-                      case 2: std::copy(std::begin(DMajorIntervals), std::end(DMajorIntervals), std::begin(keyIntervals)); break;
-                      case 3: std::copy(std::begin(DSharpMajorIntervals), std::end(DSharpMajorIntervals), std::begin(keyIntervals)); break;
-                      case 4: std::copy(std::begin(EMajorIntervals), std::end(EMajorIntervals), std::begin(keyIntervals)); break;
-                      case 5: std::copy(std::begin(FMajorIntervals), std::end(FMajorIntervals), std::begin(keyIntervals)); break;
-                      case 6: std::copy(std::begin(FSharpMajorIntervals), std::end(FSharpMajorIntervals), std::begin(keyIntervals)); break;
-                      case 7: std::copy(std::begin(GMajorIntervals), std::end(GMajorIntervals), std::begin(keyIntervals)); break;
-                      case 8: std::copy(std::begin(GSharpMajorIntervals), std::end(GSharpMajorIntervals), std::begin(keyIntervals)); break;
-                      case 9: std::copy(std::begin(AMajorIntervals), std::end(AMajorIntervals), std::begin(keyIntervals)); break;
-                      case 10: std::copy(std::begin(ASharpMajorIntervals), std::end(ASharpMajorIntervals), std::begin(keyIntervals)); break;
-                      case 11: std::copy(std::begin(BMajorIntervals), std::end(BMajorIntervals), std::begin(keyIntervals)); break;
-                      case 12: std::copy(std::begin(CMinorIntervals), std::end(CMinorIntervals), std::begin(keyIntervals)); break;
-                      case 13: std::copy(std::begin(CSharpMinorIntervals), std::end(CSharpMinorIntervals), std::begin(keyIntervals)); break;
-                      case 14: std::copy(std::begin(DMinorIntervals), std::end(DMinorIntervals), std::begin(keyIntervals)); break;
-                      case 15: std::copy(std::begin(DSharpMinorIntervals), std::end(DSharpMinorIntervals), std::begin(keyIntervals)); break;
-                      case 16: std::copy(std::begin(EMinorIntervals), std::end(EMinorIntervals), std::begin(keyIntervals)); break;
-                      case 17: std::copy(std::begin(FMinorIntervals), std::end(FMinorIntervals), std::begin(keyIntervals)); break;
-                      case 18: std::copy(std::begin(FSharpMinorIntervals), std::end(FSharpMinorIntervals), std::begin(keyIntervals)); break;
-                      case 19: std::copy(std::begin(GMinorIntervals), std::end(GMinorIntervals), std::begin(keyIntervals)); break;
-                      case 20: std::copy(std::begin(GSharpMinorIntervals), std::end(GSharpMinorIntervals), std::begin(keyIntervals)); break;
-                      case 21: std::copy(std::begin(AMinorIntervals), std::end(AMinorIntervals), std::begin(keyIntervals)); break;
-                      case 22: std::copy(std::begin(ASharpMinorIntervals), std::end(ASharpMinorIntervals), std::begin(keyIntervals)); break;
-                      case 23: std::copy(std::begin(BMinorIntervals), std::end(BMinorIntervals), std::begin(keyIntervals)); break;
-                      default: std::copy(std::begin(CMajorIntervals), std::end(CMajorIntervals), std::begin(keyIntervals)); break;
-                  }
-                    
-                    while (skips != -1){
-                      note = note+1;
-                      if (std::find(keyIntervals.begin(), keyIntervals.end(), note) != keyIntervals.end()){
-                        if (skips == 0){
-                          chosenNote = note;
-                        }
-                        skips = skips - 1;
-                      }
-                    }
-                  }
-                else if (intervalChoice >= 0.5)
-                  {
-                    int skipNotes = rand() % 4;
-                    
-
-                    switch (maxIndex) {
-                      case 0:
-                          std::copy(std::begin(CMajor), std::end(CMajor), std::begin(keyNotes));
-                          break;
-                      case 1:
-                          std::copy(std::begin(CSharpMajor), std::end(CSharpMajor), std::begin(keyNotes));
-                          break;
-                      case 2:
-                          std::copy(std::begin(DMajor), std::end(DMajor), std::begin(keyNotes));
-                          break;
-                      case 3:
-                          std::copy(std::begin(DSharpMajor), std::end(DSharpMajor), std::begin(keyNotes));
-                          break;
-                      case 4:
-                          std::copy(std::begin(EMajor), std::end(EMajor), std::begin(keyNotes));
-                          break;
-                      case 5:
-                          std::copy(std::begin(FMajor), std::end(FMajor), std::begin(keyNotes));
-                          break;
-                      case 6:
-                          std::copy(std::begin(FSharpMajor), std::end(FSharpMajor), std::begin(keyNotes));
-                          break;
-                      case 7:
-                          std::copy(std::begin(GMajor), std::end(GMajor), std::begin(keyNotes));
-                          break;
-                      case 8:
-                          std::copy(std::begin(GSharpMajor), std::end(GSharpMajor), std::begin(keyNotes));
-                          break;
-                      case 9:
-                          std::copy(std::begin(AMajor), std::end(AMajor), std::begin(keyNotes));
-                          break;
-                      case 10:
-                          std::copy(std::begin(ASharpMajor), std::end(ASharpMajor), std::begin(keyNotes));
-                          break;
-                      case 11:
-                          std::copy(std::begin(BMajor), std::end(BMajor), std::begin(keyNotes));
-                          break;
-                      case 12:
-                          std::copy(std::begin(CMinor), std::end(CMinor), std::begin(keyNotes));
-                          break;
-                      case 13:
-                          std::copy(std::begin(CSharpMinor), std::end(CSharpMinor), std::begin(keyNotes));
-                          break;
-                      case 14:
-                          std::copy(std::begin(DMinor), std::end(DMinor), std::begin(keyNotes));
-                          break;
-                      case 15:
-                          std::copy(std::begin(DSharpMinor), std::end(DSharpMinor), std::begin(keyNotes));
-                          break;
-                      case 16:
-                          std::copy(std::begin(EMinor), std::end(EMinor), std::begin(keyNotes));
-                          break;
-                      case 17:
-                          std::copy(std::begin(FMinor), std::end(FMinor), std::begin(keyNotes));
-                          break;
-                      case 18:
-                          std::copy(std::begin(FSharpMinor), std::end(FSharpMinor), std::begin(keyNotes));
-                          break;
-                      case 19:
-                          std::copy(std::begin(GMinor), std::end(GMinor), std::begin(keyNotes));
-                          break;
-                      case 20:
-                          std::copy(std::begin(GSharpMinor), std::end(GSharpMinor), std::begin(keyNotes));
-                          break;
-                      case 21:
-                          std::copy(std::begin(AMinor), std::end(AMinor), std::begin(keyNotes));
-                          break;
-                      case 22:
-                          std::copy(std::begin(ASharpMinor), std::end(ASharpMinor), std::begin(keyNotes));
-                          break;
-                      case 23:
-                          std::copy(std::begin(BMinor), std::end(BMinor), std::begin(keyNotes));
-                          break;
-                      default:
-                          std::copy(std::begin(CMajor), std::end(CMajor), std::begin(keyNotes));
-                          break;
-                  }
-
-                    while (skipNotes != -1){
-                      note = note+1;
-                      if (std::find(keyNotes.begin(), keyNotes.end(), note) != keyNotes.end()){
-                        if (skipNotes == 0){
-                          chosenNote = note;
-                        }
-                        skipNotes = skipNotes - 1;
-                      }
-                    }
-                  }
-              }
-
-              else if (positiveChoice <= 0.5)
-              {
-                if (intervalChoice >= 0 && intervalChoice < 0.5)
-                  {
-                    int skips = rand() % 4;
-                    
-                    switch (maxIndex) {
-                      case 0: std::copy(std::begin(CMajorIntervals), std::end(CMajorIntervals), std::begin(keyIntervals)); break;
-                      case 1: std::copy(std::begin(CSharpMajorIntervals), std::end(CSharpMajorIntervals), std::begin(keyIntervals)); break;
-                      case 2: std::copy(std::begin(DMajorIntervals), std::end(DMajorIntervals), std::begin(keyIntervals)); break;
-                      case 3: std::copy(std::begin(DSharpMajorIntervals), std::end(DSharpMajorIntervals), std::begin(keyIntervals)); break;
-                      case 4: std::copy(std::begin(EMajorIntervals), std::end(EMajorIntervals), std::begin(keyIntervals)); break;
-                      case 5: std::copy(std::begin(FMajorIntervals), std::end(FMajorIntervals), std::begin(keyIntervals)); break;
-                      case 6: std::copy(std::begin(FSharpMajorIntervals), std::end(FSharpMajorIntervals), std::begin(keyIntervals)); break;
-                      case 7: std::copy(std::begin(GMajorIntervals), std::end(GMajorIntervals), std::begin(keyIntervals)); break;
-                      case 8: std::copy(std::begin(GSharpMajorIntervals), std::end(GSharpMajorIntervals), std::begin(keyIntervals)); break;
-                      case 9: std::copy(std::begin(AMajorIntervals), std::end(AMajorIntervals), std::begin(keyIntervals)); break;
-                      case 10: std::copy(std::begin(ASharpMajorIntervals), std::end(ASharpMajorIntervals), std::begin(keyIntervals)); break;
-                      case 11: std::copy(std::begin(BMajorIntervals), std::end(BMajorIntervals), std::begin(keyIntervals)); break;
-                      case 12: std::copy(std::begin(CMinorIntervals), std::end(CMinorIntervals), std::begin(keyIntervals)); break;
-                      case 13: std::copy(std::begin(CSharpMinorIntervals), std::end(CSharpMinorIntervals), std::begin(keyIntervals)); break;
-                      case 14: std::copy(std::begin(DMinorIntervals), std::end(DMinorIntervals), std::begin(keyIntervals)); break;
-                      case 15: std::copy(std::begin(DSharpMinorIntervals), std::end(DSharpMinorIntervals), std::begin(keyIntervals)); break;
-                      case 16: std::copy(std::begin(EMinorIntervals), std::end(EMinorIntervals), std::begin(keyIntervals)); break;
-                      case 17: std::copy(std::begin(FMinorIntervals), std::end(FMinorIntervals), std::begin(keyIntervals)); break;
-                      case 18: std::copy(std::begin(FSharpMinorIntervals), std::end(FSharpMinorIntervals), std::begin(keyIntervals)); break;
-                      case 19: std::copy(std::begin(GMinorIntervals), std::end(GMinorIntervals), std::begin(keyIntervals)); break;
-                      case 20: std::copy(std::begin(GSharpMinorIntervals), std::end(GSharpMinorIntervals), std::begin(keyIntervals)); break;
-                      case 21: std::copy(std::begin(AMinorIntervals), std::end(AMinorIntervals), std::begin(keyIntervals)); break;
-                      case 22: std::copy(std::begin(ASharpMinorIntervals), std::end(ASharpMinorIntervals), std::begin(keyIntervals)); break;
-                      case 23: std::copy(std::begin(BMinorIntervals), std::end(BMinorIntervals), std::begin(keyIntervals)); break;
-                      default: std::copy(std::begin(CMajorIntervals), std::end(CMajorIntervals), std::begin(keyIntervals)); break;
-                  }
-                    
-                    while (skips != -1){
-                      note = note-1;
-                      if (std::find(keyIntervals.begin(), keyIntervals.end(), note) != keyIntervals.end()){
-                        if (skips == 0){
-                          chosenNote = note;
-                        }
-                        skips = skips - 1;
-                      }
-                    }
-                  }
-                else if (intervalChoice >= 0.5)
-                  {
-                    int skipNotes = rand() % 4;
-                    
-                    switch (maxIndex) {
-                      case 0:
-                          std::copy(std::begin(CMajor), std::end(CMajor), std::begin(keyNotes));
-                          break;
-                      case 1:
-                          std::copy(std::begin(CSharpMajor), std::end(CSharpMajor), std::begin(keyNotes));
-                          break;
-                      case 2:
-                          std::copy(std::begin(DMajor), std::end(DMajor), std::begin(keyNotes));
-                          break;
-                      case 3:
-                          std::copy(std::begin(DSharpMajor), std::end(DSharpMajor), std::begin(keyNotes));
-                          break;
-                      case 4:
-                          std::copy(std::begin(EMajor), std::end(EMajor), std::begin(keyNotes));
-                          break;
-                      case 5:
-                          std::copy(std::begin(FMajor), std::end(FMajor), std::begin(keyNotes));
-                          break;
-                      case 6:
-                          std::copy(std::begin(FSharpMajor), std::end(FSharpMajor), std::begin(keyNotes));
-                          break;
-                      case 7:
-                          std::copy(std::begin(GMajor), std::end(GMajor), std::begin(keyNotes));
-                          break;
-                      case 8:
-                          std::copy(std::begin(GSharpMajor), std::end(GSharpMajor), std::begin(keyNotes));
-                          break;
-                      case 9:
-                          std::copy(std::begin(AMajor), std::end(AMajor), std::begin(keyNotes));
-                          break;
-                      case 10:
-                          std::copy(std::begin(ASharpMajor), std::end(ASharpMajor), std::begin(keyNotes));
-                          break;
-                      case 11:
-                          std::copy(std::begin(BMajor), std::end(BMajor), std::begin(keyNotes));
-                          break;
-                      case 12:
-                          std::copy(std::begin(CMinor), std::end(CMinor), std::begin(keyNotes));
-                          break;
-                      case 13:
-                          std::copy(std::begin(CSharpMinor), std::end(CSharpMinor), std::begin(keyNotes));
-                          break;
-                      case 14:
-                          std::copy(std::begin(DMinor), std::end(DMinor), std::begin(keyNotes));
-                          break;
-                      case 15:
-                          std::copy(std::begin(DSharpMinor), std::end(DSharpMinor), std::begin(keyNotes));
-                          break;
-                      case 16:
-                          std::copy(std::begin(EMinor), std::end(EMinor), std::begin(keyNotes));
-                          break;
-                      case 17:
-                          std::copy(std::begin(FMinor), std::end(FMinor), std::begin(keyNotes));
-                          break;
-                      case 18:
-                          std::copy(std::begin(FSharpMinor), std::end(FSharpMinor), std::begin(keyNotes));
-                          break;
-                      case 19:
-                          std::copy(std::begin(GMinor), std::end(GMinor), std::begin(keyNotes));
-                          break;
-                      case 20:
-                          std::copy(std::begin(GSharpMinor), std::end(GSharpMinor), std::begin(keyNotes));
-                          break;
-                      case 21:
-                          std::copy(std::begin(AMinor), std::end(AMinor), std::begin(keyNotes));
-                          break;
-                      case 22:
-                          std::copy(std::begin(ASharpMinor), std::end(ASharpMinor), std::begin(keyNotes));
-                          break;
-                      case 23:
-                          std::copy(std::begin(BMinor), std::end(BMinor), std::begin(keyNotes));
-                          break;
-                      default:
-                          std::copy(std::begin(CMajor), std::end(CMajor), std::begin(keyNotes));
-                          break;
-                  }
-
-                    while (skipNotes != -1){
-                      note = note-1;
-                      if (std::find(keyNotes.begin(), keyNotes.end(), note) != keyNotes.end()){
-                        if (skipNotes == 0){
-                          chosenNote = note;
-                        }
-                        skipNotes = skipNotes - 1;
-                      }
-                    }
-                  }
-              }
+              // one to four notes of the key's chord or of its scale, up or down
+              const ScaleTables::NoteTable& table = intervalChoice < 0.5 ? ScaleTables::chords[maxIndex] : ScaleTables::scales[maxIndex];
+              int steps = stepRandom(randomGenerator);
+              int stepped = positiveChoice > 0.5 ? table.stepUp(note, steps) : table.stepDown(note, steps);
+              if (stepped != -1) chosenNote = stepped;
             }
           }
+          if (chosenNote < 0 || chosenNote > 127) continue;
+          // still sounding from before, so end it first rather than losing its off
+          if (noteOffs.cancel((std::uint8_t) chosenNote))
+            generatedMessages.addEvent(juce::MidiMessage::noteOff(1, chosenNote, 0.0f), offset);
           juce::MidiMessage nOn = juce::MidiMessage::noteOn(1, chosenNote, velocity);
-          generatedMessages.addEvent(nOn, 0);
-          noteOffTimes[chosenNote] = elapsedSamples + duration; 
+          generatedMessages.addEvent(nOn, offset);
+          notesGenerated ++;
+          if (!noteOffs.schedule((std::uint8_t) chosenNote, playTime + duration))
+            MARKOV_LOG_VALUE(warning, "MidiMarkovProcessor no room for the note off of", chosenNote, 1000);
       }
     }
-    unsigned long nextIoI = std::stoi(iOIModel.getEvent());
+    // draw the next event now, as its IOI is how long to wait for it
+    nextEvent = drawEvent();
+    unsigned long nextIoI = iOIQuantiser.dequantise(nextEvent.iOI);
 
     
     if (nextIoI > 0){
-      modelPlayNoteTime = elapsedSamples + nextIoI;
-      
-    } 
+      modelPlayNoteTime = playTime + nextIoI;
+    }
+    else {
+      // nothing to time it by, so try again next block rather than piling events up here
+      modelPlayNoteTime = lastSample + 1;
+    }
+  }
+}
+
+void MidiMarkovProcessor::sendDueNoteOffs(juce::MidiBuffer& out, unsigned long end)
+{
+  NoteOffScheduler::NoteOff due{};
+  while (noteOffs.popDue(end, due))
+  {
+    int offset = due.time > elapsedSamples ? (int) (due.time - elapsedSamples) : 0;
+    out.addEvent(juce::MidiMessage::noteOff(1, due.note, 0.0f), offset);
   }
-  return generatedMessages;
 }
 
 bool MidiMarkovProcessor::isTimeToPlayNote(unsigned long currentTime)
@@ -706,39 +617,18 @@ void MidiMarkovProcessor::updateTimeForNextPlay()
 
 }
 
-std::string MidiMarkovProcessor::notesToMarkovState(
-               const std::vector<int>& notesVec)
-{
-std::string state{""};
-for (const int& note : notesVec){
-  state += std::to_string(note) + "-";
-}
-return state; 
-}
-
-std::vector<int> MidiMarkovProcessor::markovStateToNotes(
-              const std::string& notesStr)
-{
-  std::vector<int> notes{};
-  if (notesStr == "0") return notes;
-  for (const std::string& note : 
-           MarkovChain::tokenise(notesStr, '-')){
-    notes.push_back(std::stoi(note));
-  }
-  return notes; 
-}
-
 void MidiMarkovProcessor::saveMarkovModel(const juce::File& file)
 {
-    juce::String combinedModel = "#PITCH#" + juce::String(pitchModel.getModelAsString()) +
-                                 "#IOI#" + juce::String(iOIModel.getModelAsString()) +
-                                 "#DURATION#" + juce::String(noteDurationModel.getModelAsString()) +
-                                 "#VELOCITY#" + juce::String(velocityModel.getModelAsString())
+    // save the copies of everything played so far
+    augmenter.flush();
+    juce::String combinedModel = "#EVENTS#" + juce::String(eventModel.getModelAsString())
                                  + "#KEYARRAY#";
     
-    for (int i=0; i<24; i++){
-      combinedModel = combinedModel + juce::String(keyProbs[i]) + "-";
-    }
+    combinedModel = combinedModel + juce::String(keyDetector.toString());
+    combinedModel = combinedModel + "#PITCHENCODING#" + (relativePitchOn ? "relative" : "absolute");
+    combinedModel = combinedModel + "#IOITIMING#" + juce::String(iOIQuantiser.toString()) +
+                                    "#DURATIONTIMING#" + juce::String(durationQuantiser.toString());
+    combinedModel = combinedModel + "#ENGINE#" + engineName(eventModel.getEngine());
     
     file.replaceWithText(combinedModel);
 }
@@ -749,469 +639,67 @@ void MidiMarkovProcessor::loadMarkovModel(const juce::File& file)
     {
         juce::String combinedModel = file.loadFileAsString();
         //combinedModel = combinedModel.replace("\r", "");
-        juce::String pitchString = combinedModel.fromFirstOccurrenceOf("#PITCH#", false, false)
-                                      .upToFirstOccurrenceOf("#IOI#", false, false);
-        //file.replaceWithText(pitchString);
-        juce::String IOIString = combinedModel.fromFirstOccurrenceOf("#IOI#", false, false)
-                                    .upToFirstOccurrenceOf("#DURATION#", false, false);
-        juce::String durationString = combinedModel.fromFirstOccurrenceOf("#DURATION#", false, false)
-                                         .upToFirstOccurrenceOf("#VELOCITY#", false, false);
-        juce::String velocityString = combinedModel.fromFirstOccurrenceOf("#VELOCITY#", false, false)
-                                          .upToFirstOccurrenceOf("#KEYARRAY#", false, false);   
-        juce::String keyString = combinedModel.fromFirstOccurrenceOf("#KEYARRAY#", false, false);  
-        
-        int maxSize = 24;
-        int count = 0;
-
-        juce::StringArray tokens;
-        tokens.addTokens(keyString, "-", "");
-
-        for (int i = 0; i < tokens.size() && i < maxSize; ++i) {
-            keyProbs[i] = tokens[i].getIntValue();
-            count++;
+        juce::String eventString = combinedModel.fromFirstOccurrenceOf("#EVENTS#", false, false)
+                                      .upToFirstOccurrenceOf("#KEYARRAY#", false, false);
+        juce::String keyString = combinedModel.fromFirstOccurrenceOf("#KEYARRAY#", false, false)
+                                      .upToFirstOccurrenceOf("#PITCHENCODING#", false, false);
+        // older models don't say, and they were all absolute
+        juce::String pitchEncoding = combinedModel.fromFirstOccurrenceOf("#PITCHENCODING#", false, false)
+                                          .upToFirstOccurrenceOf("#IOITIMING#", false, false);
+        juce::String iOITiming = combinedModel.fromFirstOccurrenceOf("#IOITIMING#", false, false)
+                                      .upToFirstOccurrenceOf("#DURATIONTIMING#", false, false);
+        juce::String durationTiming = combinedModel.fromFirstOccurrenceOf("#DURATIONTIMING#", false, false)
+                                           .upToFirstOccurrenceOf("#ENGINE#", false, false);
+        // older models were all stored in the chain
+        juce::String engine = combinedModel.fromFirstOccurrenceOf("#ENGINE#", false, false);
+
+        // everything from here is read by processBlock
+        ScopedSuspend suspend{*this};
+        // older models kept a count for each key, so start from the one that was winning
+        if (!keyDetector.fromString(keyString.trim().toStdString()))
+        {
+          juce::StringArray tokens;
+          tokens.addTokens(keyString, "-", "");
+          int savedKey = -1;
+          for (int i = 0, best = 0; i < tokens.size() && i < KeyDetector::numKeys; ++i)
+          {
+            if (tokens[i].getIntValue() > best)
+            {
+              best = tokens[i].getIntValue();
+              savedKey = i;
+            }
+          }
+          keyDetector.setKey(savedKey);
         }
 
         keyLoaded = false;
         
-        std::string pitchStringStd = pitchString.toStdString();
-        
-        pitchModel.setupModelFromString(pitchStringStd);
-        iOIModel.setupModelFromString(IOIString.toStdString());
-        noteDurationModel.setupModelFromString(durationString.toStdString());
-        velocityModel.setupModelFromString(velocityString.toStdString());
+        relativePitchOn = pitchEncoding.trim() == "relative";
+        pitchEncoder.reset();
+        augmenter.flush();
+        eventModel.reset();
+        pendingCount = 0;
+        eventModel.setEngine(engineFromName(engine.trim()));
+        nextEvent = NoteEvent{};
+        lastIOIBin = 0;
+        // older models kept a model per attribute, which can't be joined back up,
+        // so only their key is loaded
+        if (combinedModel.contains("#EVENTS#") &&
+            iOIQuantiser.fromString(iOITiming.trim().toStdString()) &&
+            durationQuantiser.fromString(durationTiming.trim().toStdString()))
+        {
+          eventModel.setupModelFromString(eventString.toStdString());
+        }
+        else
+        {
+          iOIQuantiser.reset();
+          durationQuantiser.reset();
+        }
 
         
     }
 }
 
-void MidiMarkovProcessor::analyzeKey(int noteNumber){
-
-    
-    //C Major
-    if (std::find(std::begin(CMajor), std::end(CMajor), noteNumber) 
-                                  != std::end(CMajor))
-    {
-      keyProbs[0] = keyProbs[0] + 1;
-    }
-    if (std::find(std::begin(CMajorIntervals), std::end(CMajorIntervals), noteNumber) 
-                                  != std::end(CMajorIntervals))
-    {
-      keyProbs[0] = keyProbs[0] + 1;
-    }
-    if (noteNumber % 12 == 0){
-        keyProbs[0] = keyProbs[0] + 1;
-    }
-
-    //C# Major
-    if (std::find(std::begin(CSharpMajor), std::end(CSharpMajor), noteNumber) 
-                                  != std::end(CSharpMajor))
-    {
-      keyProbs[1] = keyProbs[1] + 1;
-    }
-    if (std::find(std::begin(CSharpMajorIntervals), std::end(CSharpMajorIntervals), noteNumber) 
-                                  != std::end(CSharpMajorIntervals))
-    {
-      keyProbs[1] = keyProbs[1] + 1;
-    }
-    if (noteNumber % 12 == 1){
-        keyProbs[1] = keyProbs[1] + 1;
-    }
-
-    //D Major
-    if (std::find(std::begin(DMajor), std::end(DMajor), noteNumber) 
-                                  != std::end(DMajor))
-    {
-      keyProbs[2] = keyProbs[2] + 1;
-    }
-    if (std::find(std::begin(DMajorIntervals), std::end(DMajorIntervals), noteNumber) 
-                                  != std::end(DMajorIntervals))
-    {
-      keyProbs[2] = keyProbs[2] + 1;
-    }
-    if (noteNumber % 12 == 2){
-        keyProbs[2] = keyProbs[2] + 1;
-    }
-
-    //D# Major
-    if (std::find(std::begin(DSharpMajor), std::end(DSharpMajor), noteNumber) 
-                                  != std::end(DSharpMajor))
-    {
-      keyProbs[3] = keyProbs[3] + 1;
-    }
-    if (std::find(std::begin(DSharpMajorIntervals), std::end(DSharpMajorIntervals), noteNumber) 
-                                  != std::end(DSharpMajorIntervals))
-    {
-      keyProbs[3] = keyProbs[3] + 1;
-    }
-    if (noteNumber % 12 == 3){
-        keyProbs[3] = keyProbs[3] + 1;
-    }
-
-    //E Major
-    if (std::find(std::begin(EMajor), std::end(EMajor), noteNumber) 
-                                  != std::end(EMajor))
-    {
-      keyProbs[4] = keyProbs[4] + 1;
-    }
-    if (std::find(std::begin(EMajorIntervals), std::end(EMajorIntervals), noteNumber) 
-                                  != std::end(EMajorIntervals))
-    {
-      keyProbs[4] = keyProbs[4] + 1;
-    }
-    if (noteNumber % 12 == 4){
-        keyProbs[4] = keyProbs[4] + 1;
-    }
-
-    //F Major
-    if (std::find(std::begin(FMajor), std::end(FMajor), noteNumber) 
-                                  != std::end(FMajor))
-    {
-      keyProbs[5] = keyProbs[5] + 1;
-    }
-    if (std::find(std::begin(FMajorIntervals), std::end(FMajorIntervals), noteNumber) 
-                                  != std::end(FMajorIntervals))
-    {
-      keyProbs[5] = keyProbs[5] + 1;
-    }
-    if (noteNumber % 12 == 5){
-        keyProbs[5] = keyProbs[5] + 1;
-    }
-
-    //F# Major
-    if (std::find(std::begin(FSharpMajor), std::end(FSharpMajor), noteNumber) 
-                                  != std::end(FSharpMajor))
-    {
-      keyProbs[6] = keyProbs[6] + 1;
-    }
-    if (std::find(std::begin(FSharpMajorIntervals), std::end(FSharpMajorIntervals), noteNumber) 
-                                  != std::end(FSharpMajorIntervals))
-    {
-      keyProbs[6] = keyProbs[6] + 1;
-    }
-    if (noteNumber % 12 == 6){
-        keyProbs[6] = keyProbs[6] + 1;
-    }
-
-    //G Major
-    if (std::find(std::begin(GMajor), std::end(GMajor), noteNumber) 
-                                  != std::end(GMajor))
-    {
-      keyProbs[7] = keyProbs[7] + 1;
-    }
-    if (std::find(std::begin(GMajorIntervals), std::end(GMajorIntervals), noteNumber) 
-                                  != std::end(GMajorIntervals))
-    {
-      keyProbs[7] = keyProbs[7] + 1;
-    }
-    if (noteNumber % 12 == 7){
-        keyProbs[7] = keyProbs[7] + 1;
-    }
-
-    //G# Major
-    if (std::find(std::begin(GSharpMajor), std::end(GSharpMajor), noteNumber) 
-                                  != std::end(GSharpMajor))
-    {
-      keyProbs[8] = keyProbs[8] + 1;
-    }
-    if (std::find(std::begin(GSharpMajorIntervals), std::end(GSharpMajorIntervals), noteNumber) 
-                                  != std::end(GSharpMajorIntervals))
-    {
-      keyProbs[8] = keyProbs[8] + 1;
-    }
-    if (noteNumber % 12 == 8){
-        keyProbs[8] = keyProbs[8] + 1;
-    }
-
-    //A Major
-    if (std::find(std::begin(AMajor), std::end(AMajor), noteNumber) 
-                                  != std::end(AMajor))
-    {
-      keyProbs[9] = keyProbs[9] + 1;
-    }
-    if (std::find(std::begin(AMajorIntervals), std::end(AMajorIntervals), noteNumber) 
-                                  != std::end(AMajorIntervals))
-    {
-      keyProbs[9] = keyProbs[9] + 1;
-    }
-    if (noteNumber % 12 == 9){
-        keyProbs[9] = keyProbs[9] + 1;
-    }
-
-    //A# Major
-    if (std::find(std::begin(ASharpMajor), std::end(ASharpMajor), noteNumber) 
-                                  != std::end(ASharpMajor))
-    {
-      keyProbs[10] = keyProbs[10] + 1;
-    }
-    if (std::find(std::begin(ASharpMajorIntervals), std::end(ASharpMajorIntervals), noteNumber) 
-                                  != std::end(ASharpMajorIntervals))
-    {
-      keyProbs[10] = keyProbs[10] + 1;
-    }
-    if (noteNumber % 12 == 10){
-        keyProbs[10] = keyProbs[10] + 1;
-    }
-
-    //B Major
-    if (std::find(std::begin(BMajor), std::end(BMajor), noteNumber) 
-                                  != std::end(BMajor))
-    {
-      keyProbs[11] = keyProbs[11] + 1;
-    }
-    if (std::find(std::begin(BMajorIntervals), std::end(BMajorIntervals), noteNumber) 
-                                  != std::end(BMajorIntervals))
-    {
-      keyProbs[11] = keyProbs[11] + 1;
-    }
-    if (noteNumber % 12 == 11){
-        keyProbs[11] = keyProbs[11] + 1;
-    }
-
-    //C Minor
-    if (std::find(std::begin(CMinor), std::end(CMinor), noteNumber) != std::end(CMinor))
-    {
-      keyProbs[12] = keyProbs[12] + 1;
-    }
-    if (std::find(std::begin(CMinorIntervals), std::end(CMinorIntervals), noteNumber) != std::end(CMinorIntervals))
-    {
-      keyProbs[12] = keyProbs[12] + 1;
-    }
-    if (noteNumber % 12 == 0){
-        keyProbs[12] = keyProbs[12] + 1;
-    }
-
-    //C# Minor
-    if (std::find(std::begin(CSharpMinor), std::end(CSharpMinor), noteNumber) != std::end(CSharpMinor))
-    {
-      keyProbs[13] = keyProbs[13] + 1;
-    }
-    if (std::find(std::begin(CSharpMinorIntervals), std::end(CSharpMinorIntervals), noteNumber) != std::end(CSharpMinorIntervals))
-    {
-      keyProbs[13] = keyProbs[13] + 1;
-    }
-    if (noteNumber % 12 == 1){
-        keyProbs[13] = keyProbs[13] + 1;
-    }
-
-    //D Minor
-    if (std::find(std::begin(DMinor), std::end(DMinor), noteNumber) != std::end(DMinor))
-    {
-      keyProbs[14] = keyProbs[14] + 1;
-    }
-    if (std::find(std::begin(DMinorIntervals), std::end(DMinorIntervals), noteNumber) != std::end(DMinorIntervals))
-    {
-      keyProbs[14] = keyProbs[14] + 1;
-    }
-    if (noteNumber % 12 == 2){
-        keyProbs[14] = keyProbs[14] + 1;
-    }
-
-    //D# Minor
-    if (std::find(std::begin(DSharpMinor), std::end(DSharpMinor), noteNumber) != std::end(DSharpMinor))
-    {
-      keyProbs[15] = keyProbs[15] + 1;
-    }
-    if (std::find(std::begin(DSharpMinorIntervals), std::end(DSharpMinorIntervals), noteNumber) != std::end(DSharpMinorIntervals))
-    {
-      keyProbs[15] = keyProbs[15] + 1;
-    }
-    if (noteNumber % 12 == 3){
-        keyProbs[15] = keyProbs[15] + 1;
-    }
-
-    //E Minor
-    if (std::find(std::begin(EMinor), std::end(EMinor), noteNumber) != std::end(EMinor))
-    {
-      keyProbs[16] = keyProbs[16] + 1;
-    }
-    if (std::find(std::begin(EMinorIntervals), std::end(EMinorIntervals), noteNumber) != std::end(EMinorIntervals))
-    {
-      keyProbs[16] = keyProbs[16] + 1;
-    }
-    if (noteNumber % 12 == 4){
-        keyProbs[16] = keyProbs[16] + 1;
-    }
-
-    //F Minor
-    if (std::find(std::begin(FMinor), std::end(FMinor), noteNumber) != std::end(FMinor))
-    {
-      keyProbs[17] = keyProbs[17] + 1;
-    }
-    if (std::find(std::begin(FMinorIntervals), std::end(FMinorIntervals), noteNumber) != std::end(FMinorIntervals))
-    {
-      keyProbs[17] = keyProbs[17] + 1;
-    }
-    if (noteNumber % 12 == 5){
-        keyProbs[17] = keyProbs[17] + 1;
-    }
-
-    //F# Minor
-    if (std::find(std::begin(FSharpMinor), std::end(FSharpMinor), noteNumber) != std::end(FSharpMinor))
-    {
-      keyProbs[18] = keyProbs[18] + 1;
-    }
-    if (std::find(std::begin(FSharpMinorIntervals), std::end(FSharpMinorIntervals), noteNumber) != std::end(FSharpMinorIntervals))
-    {
-      keyProbs[18] = keyProbs[18] + 1;
-    }
-    if (noteNumber % 12 == 6){
-        keyProbs[18] = keyProbs[18] + 1;
-    }
-
-    //G Minor
-    if (std::find(std::begin(GMinor), std::end(GMinor), noteNumber) != std::end(GMinor))
-    {
-      keyProbs[19] = keyProbs[19] + 1;
-    }
-    if (std::find(std::begin(GMinorIntervals), std::end(GMinorIntervals), noteNumber) != std::end(GMinorIntervals))
-    {
-      keyProbs[19] = keyProbs[19] + 1;
-    }
-    if (noteNumber % 12 == 7){
-        keyProbs[19] = keyProbs[19] + 1;
-    }
-
-    //G# Minor
-    if (std::find(std::begin(GSharpMinor), std::end(GSharpMinor), noteNumber) != std::end(GSharpMinor))
-    {
-      keyProbs[20] = keyProbs[20] + 1;
-    }
-    if (std::find(std::begin(GSharpMinorIntervals), std::end(GSharpMinorIntervals), noteNumber) != std::end(GSharpMinorIntervals))
-    {
-      keyProbs[20] = keyProbs[20] + 1;
-    }
-    if (noteNumber % 12 == 8){
-        keyProbs[20] = keyProbs[20] + 1;
-    }
-
-    //A Minor
-    if (std::find(std::begin(AMinor), std::end(AMinor), noteNumber) != std::end(AMinor))
-    {
-      keyProbs[21] = keyProbs[21] + 1;
-    }
-    if (std::find(std::begin(AMinorIntervals), std::end(AMinorIntervals), noteNumber) != std::end(AMinorIntervals))
-    {
-      keyProbs[21] = keyProbs[21] + 1;
-    }
-    if (noteNumber % 12 == 9){
-        keyProbs[21] = keyProbs[21] + 1;
-    }
-
-    //A# Minor
-    if (std::find(std::begin(ASharpMinor), std::end(ASharpMinor), noteNumber) != std::end(ASharpMinor))
-    {
-      keyProbs[22] = keyProbs[22] + 1;
-    }
-    if (std::find(std::begin(ASharpMinorIntervals), std::end(ASharpMinorIntervals), noteNumber) != std::end(ASharpMinorIntervals))
-    {
-      keyProbs[22] = keyProbs[22] + 1;
-    }
-    if (noteNumber % 12 == 10){
-        keyProbs[22] = keyProbs[22] + 1;
-    }
-
-    //B Minor
-    if (std::find(std::begin(BMinor), std::end(BMinor), noteNumber) != std::end(BMinor))
-    {
-      keyProbs[23] = keyProbs[23] + 1;
-    }
-    if (std::find(std::begin(BMinorIntervals), std::end(BMinorIntervals), noteNumber) != std::end(BMinorIntervals))
-    {
-      keyProbs[23] = keyProbs[23] + 1;
-    }
-    if (noteNumber % 12 == 11){
-        keyProbs[23] = keyProbs[23] + 1;
-    }
-
-    
-    
-    int max = 0;
-    for (int i = 0; i < 24; i++){
-        if (keyProbs[i] > max) {
-          max = keyProbs[i];
-          maxIndex = i;
-        }
-    }
-    switch (maxIndex) {
-    case 0:
-        newKey = "C Major";
-        break;
-    case 1:
-        newKey = "C# Major";
-        break;
-    case 2:
-        newKey = "D Major";
-        break;
-    case 3:
-        newKey = "D# Major";
-        break;
-    case 4:
-        newKey = "E Major";
-        break;
-    case 5:
-        newKey = "F Major"; 
-        break;
-    case 6:
-        newKey = "F# Major";
-        break;
-    case 7:
-        newKey = "G Major";
-        break;
-    case 8:
-        newKey = "G# Major";
-        break;
-    case 9:
-        newKey = "A Major";
-        break;
-    case 10:
-        newKey = "A# Major";
-        break;
-    case 11:
-        newKey = "B Major";
-        break;
-    case 12:
-        newKey = "C Minor";
-        break;
-    case 13:
-        newKey = "C# Minor";
-        break;
-    case 14:
-        newKey = "D Minor";
-        break;
-    case 15:
-        newKey = "D# Minor";
-        break;
-    case 16:
-        newKey = "E Minor";
-        break;
-    case 17:
-        newKey = "F Minor";
-        break;
-    case 18:
-        newKey = "F# Minor";
-        break;
-    case 19:
-        newKey = "G Minor";
-        break;
-    case 20:
-        newKey = "G# Minor";
-        break;
-    case 21:
-        newKey = "A Minor";
-        break;
-    case 22:
-        newKey = "A# Minor";
-        break;
-    case 23:
-        newKey = "B Minor";
-        break;
-    default:
-        newKey = "";
-    }
-    if (newKey != key){
-      key = newKey;
-      updateEditorDisplay(key);
-    }
-    
+void MidiMarkovProcessor::updateDetectedKey(){
+    maxIndex = keyDetector.detectKey();
 }
-
@@ -11,8 +11,21 @@
 // #include <JuceHeader.h>
 #include <juce_audio_processors/juce_audio_processors.h>
 #include "../../MarkovModelCPP/src/MarkovManager.h"
+#include "../../MarkovModelCPP/src/PitchSet.h"
+#include "../../MarkovModelCPP/src/RelativePitchEncoder.h"
+#include "../../MarkovModelCPP/src/TimeQuantiser.h"
+#include "../../MarkovModelCPP/src/JointEventModel.h"
+#include "../../MarkovModelCPP/src/TranspositionAugmenter.h"
+#include "../../MarkovModelCPP/src/NoteOffScheduler.h"
+#include "../../MarkovModelCPP/src/ScaleTables.h"
+#include "../../MarkovModelCPP/src/KeyDetector.h"
+#include "../../MarkovModelCPP/src/RealtimeLog.h"
 
 #include "ChordDetector.h"
+#include "PluginStatus.h"
+
+#include <atomic>
+#include <random>
 
 //==============================================================================
 /**
@@ -23,135 +36,28 @@ class MidiMarkovProcessor  : public juce::AudioProcessor
                             #endif
 {
 public:
-    MarkovManager pitchModel;
-    MarkovManager iOIModel;
-    MarkovManager noteDurationModel;    
-    MarkovManager velocityModel;
-    bool learnOn = false;
-    bool canGenerateNotes = false;
-    int CMajor[75] = {0, 2, 4, 5, 7, 9, 11, 12, 14, 16, 17, 19, 21, 23, 24, 26, 28, 29, 31, 33, 35, 36, 38, 40, 41, 43, 45, 47, 48, 
-                    50, 52, 53, 55, 57, 59, 60, 62, 64, 65, 67, 69, 71, 72, 74, 76, 77, 79, 81, 83, 84, 86, 88, 89, 91, 93, 95, 96, 98, 100,
-                    101, 103, 105, 107, 108, 110, 112, 113, 115, 117, 119, 120, 122, 124, 125, 127};
-    int CMajorIntervals[33] = {0, 4, 7, 12, 16, 19, 24, 28, 31, 36, 40, 43, 48, 52, 55, 60, 64, 67, 72, 76, 79, 84, 88, 91, 96,
-                             100, 103, 108, 112, 115, 120, 124, 127};
-
-    int CSharpMajor[74] = {1, 3, 5, 6, 8, 10, 12, 13, 15, 17, 18, 20, 22, 24, 25, 27, 29, 30, 32, 34, 36, 37, 39, 41, 42, 44, 46, 48, 49, 
-                     51, 53, 54, 56, 58, 60, 61, 63, 65, 66, 68, 70, 72, 73, 75, 77, 78, 80, 82, 84, 85, 87, 89, 90, 92, 94, 96, 97, 99, 101,
-                     102, 104, 106, 108, 109, 111, 113, 114, 116, 118, 120, 121, 123, 125, 126};
-    int CSharpMajorIntervals[32] = {1, 5, 8, 13, 17, 20, 25, 29, 32, 37, 41, 44, 49, 53, 56, 61, 65, 68, 73, 77, 80, 85, 89, 92, 97,
-                              101, 104, 109, 113, 116, 121, 125};
-
-    int DMajor[75] = {1, 2, 4, 6, 7, 9, 11, 13, 14, 16, 18, 19, 21, 23, 25, 26, 28, 30, 31, 33, 35, 37, 38, 40, 42, 43, 45, 47, 49, 50, 
-                52, 54, 55, 57, 59, 61, 62, 64, 66, 67, 69, 71, 73, 74, 76, 78, 79, 81, 83, 85, 86, 88, 90, 91, 93, 95, 97, 98, 100, 102,
-                103, 105, 107, 109, 110, 112, 114, 115, 117, 119, 121, 122, 124, 126, 127};
-    int DMajorIntervals[32] = {2, 6, 9, 14, 18, 21, 26, 30, 33, 38, 42, 45, 50, 54, 57, 62, 66, 69, 74, 78, 81, 86, 90, 93, 98,
-                         102, 105, 110, 114, 117, 122, 126};
-
-    int DSharpMajor[75] = {0, 2, 3, 5, 7, 8, 10, 12, 14, 15, 17, 19, 20, 22, 24, 26, 27, 29, 31, 32, 34, 36, 38, 39, 41, 43, 44, 46, 48, 50, 51, 
-                     53, 55, 56, 58, 60, 62, 63, 65, 67, 68, 70, 72, 74, 75, 77, 79, 80, 82, 84, 86, 87, 89, 91, 92, 94, 96, 98, 99, 101, 103,
-                     104, 106, 108, 110, 111, 113, 115, 116, 118, 120, 122, 123, 125, 127};
-    int DSharpMajorIntervals[32] = {3, 7, 10, 15, 19, 22, 27, 31, 34, 39, 43, 46, 51, 55, 58, 63, 67, 70, 75, 79, 82, 87, 91, 94, 99,
-                              103, 106, 111, 115, 118, 123, 127};
-
-    int EMajor[74] = {1, 3, 4, 6, 8, 9, 11, 13, 15, 16, 18, 20, 21, 23, 25, 27, 28, 30, 32, 33, 35, 37, 39, 40, 42, 44, 45, 47, 49, 51, 52, 
-                54, 56, 57, 59, 61, 63, 64, 66, 68, 69, 71, 73, 75, 76, 78, 80, 81, 83, 85, 87, 88, 90, 92, 93, 95, 97, 99, 100, 102, 104,
-                105, 107, 109, 111, 112, 114, 116, 117, 119, 121, 123, 124, 126};
-    int EMajorIntervals[31] = {4, 8, 11, 16, 20, 23, 28, 32, 35, 40, 44, 47, 52, 56, 59, 64, 68, 71, 76, 80, 83, 88, 92, 95, 100,
-                         104, 107, 112, 116, 119, 124};
-
-    int FMajor[75] = {0, 2, 4, 5, 7, 9, 10, 12, 14, 16, 17, 19, 21, 22, 24, 26, 28, 29, 31, 33, 34, 36, 38, 40, 41, 43, 45, 46, 48, 50, 52, 53, 
-                55, 57, 58, 60, 62, 64, 65, 67, 69, 70, 72, 74, 76, 77, 79, 81, 82, 84, 86, 88, 89, 91, 93, 94, 96, 98, 100, 101, 103, 105,
-                106, 108, 110, 112, 113, 115, 117, 118, 120, 122, 124, 125, 127};
-    int FMajorIntervals[32] = {0, 5, 9, 12, 17, 21, 24, 29, 33, 36, 41, 45, 48, 53, 57, 60, 65, 69, 72, 77, 81, 84, 89, 93, 96, 101,
-                         105, 108, 113, 117, 120, 125};
-
-    int FSharpMajor[74] = {1, 3, 5, 6, 8, 10, 11, 13, 15, 17, 18, 20, 22, 23, 25, 27, 29, 30, 32, 34, 35, 37, 39, 41, 42, 44, 46, 47, 49, 51, 53, 54, 
-                     56, 58, 59, 61, 63, 65, 66, 68, 70, 71, 73, 75, 77, 78, 80, 82, 83, 85, 87, 89, 90, 92, 94, 95, 97, 99, 101, 102, 104, 106,
-                     107, 109, 111, 113, 114, 116, 118, 119, 121, 123, 125, 126};
-    int FSharpMajorIntervals[32] = {1, 6, 10, 13, 18, 22, 25, 30, 34, 37, 42, 46, 49, 54, 58, 61, 66, 70, 73, 78, 82, 85, 90, 94, 97, 102,
-                              106, 109, 114, 118, 121, 126};  
-
-    int GMajor[75] = {0, 2, 4, 6, 7, 9, 11, 12, 14, 16, 18, 19, 21, 23, 24, 26, 28, 30, 31, 33, 35, 36, 38, 40, 42, 43, 45, 47, 48, 50, 52, 54, 55, 
-                57, 59, 60, 62, 64, 66, 67, 69, 71, 72, 74, 76, 78, 79, 81, 83, 84, 86, 88, 90, 91, 93, 95, 96, 98, 100, 102, 103, 105, 107,
-                108, 110, 112, 114, 115, 117, 119, 120, 122, 124, 126, 127};
-    int GMajorIntervals[32] = {2, 7, 11, 14, 19, 23, 26, 31, 35, 38, 43, 47, 50, 55, 59, 62, 67, 71, 74, 79, 83, 86, 91, 95, 98, 103,
-                         107, 110, 115, 119, 122, 127}; 
-
-    int GSharpMajor[75] = {0, 1, 3, 5, 7, 8, 10, 12, 13, 15, 17, 19, 20, 22, 24, 25, 27, 29, 31, 32, 34, 36, 37, 39, 41, 43, 44, 46, 48, 49, 51, 53, 55, 56, 
-                     58, 60, 61, 63, 65, 67, 68, 70, 72, 73, 75, 77, 79, 80, 82, 84, 85, 87, 89, 91, 92, 94, 96, 97, 99, 101, 103, 104, 106, 108,
-                     109, 111, 113, 115, 116, 118, 120, 121, 123, 125, 127};
-    int GSharpMajorIntervals[33] = {0, 3, 8, 12, 15, 20, 24, 27, 32, 36, 39, 44, 48, 51, 56, 60, 63, 68, 72, 75, 80, 84, 87, 92, 96, 99, 104,
-                              108, 111, 116, 120, 123, 127};
-
-    int AMajor[74] = {1, 2, 4, 6, 8, 9, 11, 13, 14, 16, 18, 20, 21, 23, 25, 26, 28, 30, 32, 33, 35, 37, 38, 40, 42, 44, 45, 47, 49, 50, 52, 54, 56, 57, 
-                59, 61, 62, 64, 66, 68, 69, 71, 73, 74, 76, 78, 80, 81, 83, 85, 86, 88, 90, 92, 93, 95, 97, 98, 100, 102, 104, 105, 107, 109,
-                110, 112, 114, 116, 117, 119, 121, 122, 124, 126};
-    int AMajorIntervals[32] = {1, 4, 9, 13, 16, 21, 25, 28, 33, 37, 40, 45, 49, 52, 57, 61, 64, 69, 73, 76, 81, 85, 88, 93, 97, 100, 105,
-                         109, 112, 117, 121, 124};
-
-    int ASharpMajor[75] = {0, 2, 3, 5, 7, 9, 10, 12, 14, 15, 17, 19, 21, 22, 24, 26, 27, 29, 31, 33, 34, 36, 38, 39, 41, 43, 45, 46, 48, 50, 51, 53, 55, 57, 58, 
-                     60, 62, 63, 65, 67, 69, 70, 72, 74, 75, 77, 79, 81, 82, 84, 86, 87, 89, 91, 93, 94, 96, 98, 99, 101, 103, 105, 106, 108, 110,
-                     111, 113, 115, 117, 118, 120, 122, 123, 125, 127};
-    int ASharpMajorIntervals[32] = {2, 5, 10, 14, 17, 22, 26, 29, 34, 38, 41, 46, 50, 53, 58, 62, 65, 70, 74, 77, 82, 86, 89, 94, 98, 101, 106,
-                              110, 113, 118, 122, 125};
-
-    int BMajor[74] = {1, 3, 4, 6, 8, 10, 11, 13, 15, 16, 18, 20, 22, 23, 25, 27, 28, 30, 32, 34, 35, 37, 39, 40, 42, 44, 46, 47, 49, 51, 52, 54, 56, 58, 59, 
-                61, 63, 64, 66, 68, 70, 71, 73, 75, 76, 78, 80, 82, 83, 85, 87, 88, 90, 92, 94, 95, 97, 99, 100, 102, 104, 106, 107, 109, 111,
-                112, 114, 116, 118, 119, 121, 123, 124, 126};
-    int BMajorIntervals[32] = {3, 6, 11, 15, 18, 23, 27, 30, 35, 39, 42, 47, 51, 54, 59, 63, 66, 71, 75, 78, 83, 87, 90, 95, 99, 102, 107,
-                         111, 114, 119, 123, 126};
-
-    int CMinor[75];
-    int CSharpMinor[73];
-    int DMinor[75];
-    int DSharpMinor[74];
-    int EMinor[75];
-    int FMinor[75];
-    int FSharpMinor[74];
-    int GMinor[75];
-    int GSharpMinor[73];
-    int AMinor[75];
-    int ASharpMinor[74];
-    int BMinor[75];
-    
-    int CMinorIntervals[33] = {0, 3, 7, 12, 15, 19, 24, 27, 31, 36, 39, 43, 48, 51, 55, 60, 63, 67, 72,
-                            75, 79, 84, 87, 91, 96, 99, 103, 108, 111, 115, 120, 123, 127};
-
-    int CSharpMinorIntervals[32] = {1, 4, 8, 13, 16, 20, 25, 28, 32, 37, 40, 44, 49, 52, 56, 61, 64, 68, 73,
-                              76, 80, 85, 88, 92, 97, 100, 104, 109, 112, 116, 121, 124};   
-
-    int DMinorIntervals[32] = {2, 5, 9, 14, 17, 21, 26, 29, 33, 38, 41, 45, 50, 53, 57, 62, 65, 69, 74,
-                         77, 81, 86, 89, 93, 98, 101, 105, 110, 113, 117, 122, 125};
-
-    int DSharpMinorIntervals[32] = {3, 6, 10, 15, 18, 22, 27, 30, 34, 39, 42, 46, 51, 54, 58, 63, 66, 70, 75,
-                              78, 82, 87, 90, 94, 99, 102, 106, 111, 114, 118, 123, 126};
-
-    int EMinorIntervals[32] = {4, 7, 11, 16, 19, 23, 28, 31, 35, 40, 43, 47, 52, 55, 59, 64, 67, 71, 76,
-                         79, 83, 88, 91, 95, 100, 103, 107, 112, 115, 119, 124, 127};
-
-    int FMinorIntervals[32] = {0, 5, 8, 12, 17, 20, 24, 29, 32, 36, 41, 44, 48, 53, 56, 60, 65, 68, 72, 77,
-                         80, 84, 89, 92, 96, 101, 104, 108, 113, 116, 120, 125};
-
-    int FSharpMinorIntervals[32] = {1, 6, 9, 13, 18, 21, 25, 30, 33, 37, 42, 45, 49, 54, 57, 61, 66, 69, 73, 78,
-                              81, 85, 90, 93, 97, 102, 105, 109, 114, 117, 121, 126};
-
-    int GMinorIntervals[32] = {2, 7, 10, 14, 19, 22, 26, 31, 34, 38, 43, 46, 50, 55, 58, 62, 67, 70, 74, 79,
-                         82, 86, 91, 94, 98, 103, 106, 110, 115, 118, 122, 127};
-
-    int GSharpMinorIntervals[31] = {3, 8, 11, 15, 20, 23, 27, 32, 35, 39, 44, 47, 51, 56, 59, 63, 68, 71, 75, 80,
-                              83, 87, 92, 95, 99, 104, 107, 111, 116, 119, 123};
-
-    int AMinorIntervals[32] = {0, 4, 9, 12, 16, 21, 24, 28, 33, 36, 40, 45, 48, 52, 57, 60, 64, 69, 72, 76, 81,
-                         84, 88, 93, 96, 100, 105, 108, 112, 117, 120, 124};
-
-    int ASharpMinorIntervals[32] = {1, 5, 10, 13, 17, 22, 25, 29, 34, 37, 41, 46, 49, 53, 58, 61, 65, 70, 73, 77, 82,
-                              85, 89, 94, 97, 101, 106, 109, 113, 118, 121, 125};
-
-    int BMinorIntervals[32] = {2, 6, 11, 14, 18, 23, 26, 30, 35, 38, 42, 47, 50, 54, 59, 62, 66, 71, 74, 78, 83,
-                         86, 90, 95, 98, 102, 107, 110, 114, 119, 122, 126};
-
-    int keyProbs[24] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    /** 
+     * each chord's notes, IOI and duration bins and velocity, learnt together.
+     * The notes are the set of notes in the chord, whatever order they arrived in
+     */
+    JointEventModel eventModel;
+    /** trains eventModel on each chord moved into the other keys, off the audio thread */
+    TranspositionAugmenter augmenter{eventModel};
+    /**
+     * what the host can automate: learning, generating and randomness.
+     * The editor attaches to these, and they are saved with the plugin state
+     */
+    juce::AudioProcessorValueTreeState parameters;
+    /** the parameter IDs, as the host and the editor's attachments know them */
+    static constexpr const char* learnParameterID = "learn";
+    static constexpr const char* generateParameterID = "generate";
+    static constexpr const char* randomnessParameterID = "randomness";
+    /** follows the key of the notes played in, with recent notes counting most */
+    KeyDetector keyDetector;
+    /** the detected key, numbered as in ScaleTables, -1 until a note has been played */
     int maxIndex = -1;
+    /** what the editor shows, published by the audio thread at the end of each block */
+    PluginStatus status;
 
     //==============================================================================
     MidiMarkovProcessor();
@@ -192,24 +98,100 @@ public:
     /** add some midi to be played at the sent sample offset*/
     void addMidi(const juce::MidiMessage& msg, int sampleOffset);
     void resetMarkovModel();
+    /**
+     * learn pitch as chord shapes and the steps between them rather than as absolute notes,
+     * so the same lick in another key follows the same path through the model.
+     * Changing it wipes the model, as the two kinds of state don't mix
+     */
+    void setRelativePitch(bool relative);
+    bool getRelativePitch();
+    /**
+     * bin times logarithmically or on a grid of the host tempo.
+     * Changing it wipes the model, as the bins mean something else
+     */
+    void setTimeQuantisation(TimeQuantiser::Mode mode);
+    TimeQuantiser::Mode getTimeQuantisation();
+    /**
+     * also learn each chord in the keys set on augmenter, so what is played in one key
+     * comes back in all of them. Has no effect with relative pitch, which is the same in every key
+     */
+    void setTranspositionAugmentation(bool augment);
+    bool getTranspositionAugmentation();
+    /**
+     * the storage engine behind eventModel, see JointEventModel::setEngine.
+     * Saved with the model, so it loads back into the engine it came from
+     */
+    void setModelEngine(ModelEngine engine);
+    ModelEngine getModelEngine();
+    /** how many seconds it takes a note to count half as much towards the key, see KeyDetector */
+    void setKeyWindow(double seconds);
+    double getKeyWindow();
 
     void saveMarkovModel(const juce::File& file);
     void loadMarkovModel(const juce::File& file);
 
-    void updateEditorDisplay(juce::String& newText);
 private:
 
-    void analysePitches(const juce::MidiBuffer& midiMessages);
-    void analyseIoI(const juce::MidiBuffer& midiMessages);
-    void analyseDuration(const juce::MidiBuffer& midiMessages);
-    void analyseVelocity(const juce::MidiBuffer& midiMessages);
-    void analyzeKey(int noteNumber);
+    /**
+     * holds processBlock off while the message thread changes what the audio thread reads.
+     * Hosts take the callback lock around each block, so this waits for a block in progress.
+     * Don't nest them, as suspension is not counted
+     */
+    struct ScopedSuspend {
+      explicit ScopedSuspend(juce::AudioProcessor& _processor)
+        : processor{_processor}, wasSuspended{_processor.isSuspended()}
+      {
+        processor.suspendProcessing(true);
+      }
+      ~ScopedSuspend()
+      {
+        processor.suspendProcessing(wasSuspended);
+      }
+      juce::AudioProcessor& processor;
+      bool wasSuspended;
+    };
+
+    /** a note on or off, decoded once per block for all the analysers */
+    struct DecodedNote {
+      /** samples since the plugin started */
+      unsigned long time;
+      juce::uint8 note;
+      juce::uint8 velocity;
+      bool isOn;
+    };
+    /** notes decoded before they are handed to the analysers, busier blocks go in several batches */
+    static constexpr std::size_t maxDecodedNotes = 256;
+
+    /** decodes the notes in the block in one pass and hands them to the analysers in batches */
+    void analyseBlock(const juce::MidiBuffer& midiMessages);
+    /** hands a batch of decoded notes to the key detector and analyseEvents. returns true if there were note ons */
+    bool dispatchNotes(std::size_t count);
+    /** follows the notes coming in and trains eventModel on each chord */
+    void analyseEvents(const DecodedNote* notes, std::size_t count);
+    /** 
+     * takes the chord chordDetect has just released, and learns it once its length is known:
+     * straight away if its bass has been let go, otherwise when it is or when the next note comes
+     */
+    void takeChord(unsigned long now);
+    /** trains eventModel on a chord, now being when it ended if its bass is still held */
+    void learnChord(const PitchSet& chord, unsigned long now);
+    /** hands pendingEvents to eventModel oldest first, stopping if a worker has the model */
+    void trainPendingEvents();
+    /** the next event from eventModel, with its notes decoded if needed */
+    NoteEvent drawEvent();
+    /** picks the key that fits best */
+    void updateDetectedKey();
+    /** hands the key, the model's size and the counters to status */
+    void publishStatus();
     
 
-    std::string notesToMarkovState (const std::vector<int>& notesVec);
-    std::vector<int> markovStateToNotes (const std::string& notesStr);
-
-    juce::MidiBuffer generateNotesFromModel(const juce::MidiBuffer& incomingMessages);
+    /**
+     * plays every event that falls in the next numSamples into generatedMessages, each at its own offset.
+     * Nothing here allocates once prepareToPlay has run
+     */
+    void generateNotesFromModel(int numSamples);
+    /** adds the note offs due before end to out, at their offsets in the current block */
+    void sendDueNoteOffs(juce::MidiBuffer& out, unsigned long end);
     // return true if time to play a note
     bool isTimeToPlayNote(unsigned long currentTime);
     // call after playing a note 
@@ -218,22 +200,75 @@ private:
     
     
 
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    /** the values behind parameters, read once at the start of each block */
+    std::atomic<float>* learnParameter;
+    std::atomic<float>* generateParameter;
+    std::atomic<float>* randomnessParameter;
+    /** the chance, in percent, of stepping a generated note through the key, ramped so automation doesn't jump */
+    juce::SmoothedValue<float> randomness;
+
+    /** true if eventModel holds RelativePitchEncoder states */
+    bool relativePitchOn = false;
+    std::array<DecodedNote, maxDecodedNotes> decodedNotes;
+    /** set from the message thread and read by learnChord on the audio thread */
+    std::atomic<bool> augmentOn{false};
+    RelativePitchEncoder pitchEncoder;
+    TimeQuantiser iOIQuantiser;
+    TimeQuantiser durationQuantiser;
+
+    /** the orders eventModel stores exactly, longer contexts go into its sketch */
+    static constexpr unsigned long exactOrders = 8;
+    /**
+     * the events eventModel's storage is preallocated for in prepareToPlay, counting
+     * the augmenter's eleven transposed copies of each chord. That is a few hundred chords
+     * if every one is new, and many more as the playing repeats itself
+     */
+    static constexpr std::size_t reservedEvents = 5000;
+
+    /** what is generated in each block, sized in prepareToPlay and reused */
+    juce::MidiBuffer generatedMessages;
+    /** room for a few hundred generated messages per block */
+    static constexpr std::size_t generatedMessagesBytes = 4096;
+    /** for the steps through the key, seeded once rather than every block */
+    std::mt19937 randomGenerator{std::random_device{}()};
+    std::uniform_real_distribution<float> unitRandom{0.0f, 1.0f};
+    /** how many notes of the chord or scale to step by */
+    std::uniform_int_distribution<int> stepRandom{1, 4};
+
     /** stores messages added from the addMidi function*/
     juce::MidiBuffer midiToProcess;
         
 
+    /** when the last chord that was learnt started */
     unsigned long lastNoteOnTime; 
+    /** the IOI bin of the last chord that came in between 0.05 and 2 seconds after the one before, 0 before there is one */
+    std::uint8_t lastIOIBin = 0;
     bool noMidiYet; 
-    unsigned long noteOffTimes[127];
-    unsigned long noteOnTimes[127];
+    /** when to turn off each generated note that is still sounding */
+    NoteOffScheduler noteOffs;
+    unsigned long noteOnTimes[128];
+    juce::uint8 noteOnVelocities[128];
+    /** how long each note was held the last time it was played, 0 if it is still held */
+    unsigned long noteLengths[128];
+    /** events learnt while eventModel was busy with the augmenter's workers, waiting to be trained */
+    static constexpr std::size_t maxPendingEvents = 64;
+    std::array<NoteEvent, maxPendingEvents> pendingEvents;
+    std::size_t pendingStart = 0;
+    std::size_t pendingCount = 0;
+    /** the event to play when modelPlayNoteTime comes, as its IOI set that time */
+    NoteEvent nextEvent;
 
     unsigned long elapsedSamples; 
     unsigned long modelPlayNoteTime;
     ChordDetector chordDetect;
+    /** a chord that has been released but whose bass is still held, so its length is not known yet */
+    PitchSet heldChord;
 
-    juce::String key = "";
-    juce::String newKey = "";
     bool keyLoaded = true;
+    /** counted on the audio thread and published through status */
+    std::uint64_t eventsLearnt = 0;
+    std::uint64_t notesGenerated = 0;
       //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiMarkovProcessor)
 };
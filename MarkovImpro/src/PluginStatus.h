@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    PluginStatus.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * What the audio thread reports to the editor: the detected key, the size of the model,
+ * the order of the last match and how many events have been learnt and notes generated.
+ *
+ * The audio thread publishes once per block and the editor reads on a timer. Each field is
+ * its own lock-free atomic, so neither side ever waits on the other and the audio thread
+ * never touches the GUI. A read can mix fields from two neighbouring blocks, which is fine
+ * for a display, and the next read catches up.
+ */
+class PluginStatus {
+  public:
+    struct Snapshot {
+      /** numbered as in ScaleTables, -1 if there is no key yet */
+      int key = -1;
+      /** contexts in the joint model */
+      long contexts = 0;
+      /** the order of the match behind the last generated event */
+      int lastOrder = 0;
+      std::uint64_t eventsLearnt = 0;
+      std::uint64_t notesGenerated = 0;
+
+      bool operator==(const Snapshot& other) const
+      {
+        return key == other.key && contexts == other.contexts && lastOrder == other.lastOrder &&
+               eventsLearnt == other.eventsLearnt && notesGenerated == other.notesGenerated;
+      }
+      bool operator!=(const Snapshot& other) const
+      {
+        return !(*this == other);
+      }
+    };
+
+    /** called from the audio thread */
+    void publish(const Snapshot& snapshot)
+    {
+      key.store(snapshot.key, std::memory_order_relaxed);
+      contexts.store(snapshot.contexts, std::memory_order_relaxed);
+      lastOrder.store(snapshot.lastOrder, std::memory_order_relaxed);
+      eventsLearnt.store(snapshot.eventsLearnt, std::memory_order_relaxed);
+      notesGenerated.store(snapshot.notesGenerated, std::memory_order_relaxed);
+    }
+    /** called from any other thread, e.g. the editor's timer */
+    Snapshot read() const
+    {
+      Snapshot snapshot;
+      snapshot.key = key.load(std::memory_order_relaxed);
+      snapshot.contexts = contexts.load(std::memory_order_relaxed);
+      snapshot.lastOrder = lastOrder.load(std::memory_order_relaxed);
+      snapshot.eventsLearnt = eventsLearnt.load(std::memory_order_relaxed);
+      snapshot.notesGenerated = notesGenerated.load(std::memory_order_relaxed);
+      return snapshot;
+    }
+
+  private:
+    std::atomic<int> key{-1};
+    std::atomic<long> contexts{0};
+    std::atomic<int> lastOrder{0};
+    std::atomic<std::uint64_t> eventsLearnt{0};
+    std::atomic<std::uint64_t> notesGenerated{0};
+};
@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    ContextSketch.cpp
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "ContextSketch.h"
+#include <algorithm>
+
+static std::uint64_t mix(std::uint64_t x)
+{
+  // splitmix64 finaliser
+  x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ull;
+  x ^= x >> 27; x *= 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+ContextSketch::ContextSketch(std::size_t _width) : width{0}
+{
+  resize(_width);
+}
+
+void ContextSketch::resize(std::size_t _width)
+{
+  width = 0;
+  if (_width > 0)
+  {
+    width = 1;
+    while (width < _width) width <<= 1;
+  }
+  counters.assign(depth * width, 0);
+  // a quarter as many contexts as counters, as each one brings several continuations
+  slots.assign(width / 4 + (width > 0 ? 1 : 0), Slot{0, {}, 0, 0});
+}
+
+void ContextSketch::clear()
+{
+  std::fill(counters.begin(), counters.end(), 0);
+  std::fill(slots.begin(), slots.end(), Slot{0, {}, 0, 0});
+}
+
+bool ContextSketch::isEnabled() const
+{
+  return width > 0;
+}
+
+void ContextSketch::add(std::uint64_t context, std::uint32_t symbol, std::uint32_t amount)
+{
+  if (width == 0) return;
+  // conservative update: only raise the counters that are at the minimum,
+  // which keeps the overestimates down
+  std::uint32_t current = estimate(context, symbol);
+  std::uint32_t target = current + amount;
+  if (target < current) target = UINT32_MAX;
+  for (std::size_t row = 0; row < depth; ++row)
+  {
+    std::uint32_t& counter = counters[counterIndex(row, context, symbol)];
+    if (counter < target) counter = target;
+  }
+  // now make sure the symbol is a candidate for the context
+  std::size_t found = findSlot(context);
+  if (found == slots.size())
+  {
+    // take whichever of our two slots is empty or weaker
+    found = slotIndex(context, 0);
+    std::size_t other = slotIndex(context, 1);
+    if (slots[other].symbolCount == 0 || 
+        (slots[found].symbolCount > 0 && slotWeight(slots[other]) < slotWeight(slots[found]))) found = other;
+    Slot& victim = slots[found];
+    // an established context only gives way once it has been
+    // passed over about as many times as it has been seen
+    if (victim.symbolCount > 0 && slotWeight(victim) > target && ++victim.misses < slotWeight(victim)) return;
+    victim = Slot{context, {}, 0, 0};
+  }
+  Slot* slot = &slots[found];
+  slot->misses = 0;
+  for (std::uint32_t i = 0; i < slot->symbolCount; ++i)
+  {
+    if (slot->symbols[i] == symbol) return;
+  }
+  if (slot->symbolCount < candidatesPerContext)
+  {
+    slot->symbols[slot->symbolCount++] = symbol;
+    return;
+  }
+  // full - replace the weakest candidate if we are now stronger
+  std::uint32_t weakest = 0;
+  for (std::uint32_t i = 1; i < slot->symbolCount; ++i)
+  {
+    if (estimate(context, slot->symbols[i]) < estimate(context, slot->symbols[weakest])) weakest = i;
+  }
+  if (estimate(context, slot->symbols[weakest]) < target) slot->symbols[weakest] = symbol;
+}
+
+std::uint32_t ContextSketch::estimate(std::uint64_t context, std::uint32_t symbol) const
+{
+  if (width == 0) return 0;
+  std::uint32_t least = UINT32_MAX;
+  for (std::size_t row = 0; row < depth; ++row)
+  {
+    least = std::min(least, counters[counterIndex(row, context, symbol)]);
+  }
+  return least;
+}
+
+std::size_t ContextSketch::getCandidates(std::uint64_t context, std::uint32_t* out) const
+{
+  std::size_t found = findSlot(context);
+  if (found == slots.size()) return 0;
+  std::copy(slots[found].symbols, slots[found].symbols + slots[found].symbolCount, out);
+  return slots[found].symbolCount;
+}
+
+void ContextSketch::removeCandidate(std::uint64_t context, std::uint32_t symbol)
+{
+  std::size_t found = findSlot(context);
+  if (found == slots.size()) return;
+  Slot* slot = &slots[found];
+  for (std::uint32_t i = 0; i < slot->symbolCount; ++i)
+  {
+    if (slot->symbols[i] != symbol) continue;
+    slot->symbols[i] = slot->symbols[slot->symbolCount - 1];
+    slot->symbolCount --;
+    return;
+  }
+}
+
+std::size_t ContextSketch::getMemoryUsed() const
+{
+  return counters.size() * sizeof(std::uint32_t) + slots.size() * sizeof(Slot);
+}
+
+std::size_t ContextSketch::counterIndex(std::size_t row, std::uint64_t context, std::uint32_t symbol) const
+{
+  return row * width + (mix(context ^ mix(symbol + (row + 1) * 0x9E3779B97F4A7C15ull)) & (width - 1));
+}
+
+std::size_t ContextSketch::slotIndex(std::uint64_t context, std::size_t which) const
+{
+  if (which == 0) return context % slots.size();
+  return mix(context) % slots.size();
+}
+
+std::size_t ContextSketch::findSlot(std::uint64_t context) const
+{
+  if (width == 0) return slots.size();
+  for (std::size_t which = 0; which < 2; ++which)
+  {
+    std::size_t index = slotIndex(context, which);
+    if (slots[index].symbolCount > 0 && slots[index].context == context) return index;
+  }
+  return slots.size();
+}
+
+std::uint64_t ContextSketch::slotWeight(const Slot& slot) const
+{
+  std::uint64_t weight = 0;
+  for (std::uint32_t i = 0; i < slot.symbolCount; ++i) weight += estimate(slot.context, slot.symbols[i]);
+  return weight;
+}
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    ContextSketch.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Fixed size, approximate store of context -> continuation counts, used by MarkovChain
+ * for contexts too long to be worth storing exactly.
+ *
+ * Counts live in a count-min sketch keyed by (context fingerprint, symbol), so they can
+ * only ever be overestimated. A sketch cannot list what follows a context, so each
+ * context fingerprint also gets a slot in a small candidate table holding its
+ * most frequent continuations. A context which keeps turning up takes the slot
+ * from one that has not been seen for a while, so the table follows the
+ * recent material. Nothing is allocated after resize.
+ */
+class ContextSketch {
+  public:
+    /** how many continuations we remember per context */
+    static constexpr std::size_t candidatesPerContext = 4;
+
+    /** width is the number of counters per row of the sketch. 0 means disabled */
+    ContextSketch(std::size_t width=0);
+    /** throw away everything and allocate width counters per row, rounded up to a power of two */
+    void resize(std::size_t width);
+    /** zero all counts and candidates, keeping the memory */
+    void clear();
+    /** true if resize has been called with a non zero width */
+    bool isEnabled() const;
+    /** count 'amount' more occurrences of symbol following context */
+    void add(std::uint64_t context, std::uint32_t symbol, std::uint32_t amount=1);
+    /** how many times symbol has followed context, never less than the true count */
+    std::uint32_t estimate(std::uint64_t context, std::uint32_t symbol) const;
+    /**
+     * copies the candidate continuations of context into out
+     * @return how many there are, 0 if the context is not in the table
+     */
+    std::size_t getCandidates(std::uint64_t context, std::uint32_t* out) const;
+    /** stop symbol being offered as a continuation of context */
+    void removeCandidate(std::uint64_t context, std::uint32_t symbol);
+    /** bytes used by the counters and the candidate table */
+    std::size_t getMemoryUsed() const;
+
+  private:
+    struct Slot {
+      std::uint64_t context;
+      std::uint32_t symbols[candidatesPerContext];
+      std::uint32_t symbolCount;
+      /** how many other contexts have tried to take the slot since it was last used */
+      std::uint32_t misses;
+    };
+    static constexpr std::size_t depth = 4;
+    /** counter for the sent row */
+    std::size_t counterIndex(std::size_t row, std::uint64_t context, std::uint32_t symbol) const;
+    /** the two slots a context can live in */
+    std::size_t slotIndex(std::uint64_t context, std::size_t which) const;
+    /** index of the slot holding context, slots.size() if there is none */
+    std::size_t findSlot(std::uint64_t context) const;
+    /** sum of the estimates of the candidates in the slot */
+    std::uint64_t slotWeight(const Slot& slot) const;
+
+    std::size_t width;
+    std::vector<std::uint32_t> counters;
+    std::vector<Slot> slots;
+};
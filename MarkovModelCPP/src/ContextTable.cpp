@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    ContextTable.cpp
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "ContextTable.h"
+#include <algorithm>
+
+ContextTable::ContextTable(std::pmr::memory_resource* arena)
+  : slots{arena}, oldSlots{arena}, migrated{0}, count{0}
+{
+
+}
+
+void ContextTable::insert(std::uint64_t fingerprint, std::uint32_t number)
+{
+  if (slots.empty()) slots.assign(initialSlots, Slot{0, notFound});
+  else if ((count + 1) * 2 > slots.size() && !isMigrating())
+  {
+    // the old table becomes the one we drain, the new one starts empty
+    oldSlots.swap(slots);
+    slots.assign(oldSlots.size() * 2, Slot{0, notFound});
+    migrated = 0;
+  }
+  place(slots, Slot{fingerprint, number});
+  count ++;
+  if (isMigrating()) migrate();
+}
+
+std::size_t ContextTable::size() const
+{
+  return count;
+}
+
+bool ContextTable::isMigrating() const
+{
+  return !oldSlots.empty();
+}
+
+std::size_t ContextTable::firstSlot(std::uint64_t fingerprint, std::size_t mask)
+{
+  return (std::size_t) (fingerprint >> 32) & mask;
+}
+
+void ContextTable::place(slot_table& table, const Slot& slot)
+{
+  std::size_t mask = table.size() - 1;
+  std::size_t i = firstSlot(slot.fingerprint, mask);
+  while (table[i].number != notFound) i = (i + 1) & mask;
+  table[i] = slot;
+}
+
+void ContextTable::migrate()
+{
+  // the new table is twice the size and the old one was half full, so moving
+  // migrateStep > 2 slots per insert empties it well before the new one needs to grow
+  std::size_t end = std::min(migrated + migrateStep, oldSlots.size());
+  for (; migrated < end; ++migrated)
+  {
+    if (oldSlots[migrated].number != notFound) place(slots, oldSlots[migrated]);
+  }
+  if (migrated == oldSlots.size())
+  {
+    // the arena keeps the memory until the model is reset
+    slot_table{oldSlots.get_allocator()}.swap(oldSlots);
+  }
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    ContextTable.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * Flat open addressing index from context fingerprints to context numbers, used by MarkovChain
+ * in place of a hash map of buckets. Each slot is the whole 64 bit fingerprint and the number,
+ * four to a cache line, and a lookup walks along neighbouring slots, so it touches one or two lines.
+ * Different contexts can share a fingerprint: find hands each candidate to the caller to check.
+ *
+ * When the table gets half full it starts a table twice the size, and every insert moves a few
+ * slots of the old one across until it is empty. No single insert rehashes the whole table,
+ * so training does not stall once the model is large. Until then, find looks in both.
+ * Entries are never removed, so there are no tombstones.
+ */
+class ContextTable {
+  public:
+    static constexpr std::uint32_t notFound = 0xFFFFFFFFu;
+
+    /** the slot arrays come from the sent arena, like the rest of the model */
+    ContextTable(std::pmr::memory_resource* arena);
+    /**
+     * calls isMatch(number) for each entry with the sent fingerprint until it returns true
+     * @return the number it returned true for, notFound if none did
+     */
+    template <typename Match>
+    std::uint32_t find(std::uint64_t fingerprint, Match isMatch) const
+    {
+      std::uint32_t number = findIn(slots, fingerprint, isMatch);
+      if (number == notFound && isMigrating()) number = findIn(oldSlots, fingerprint, isMatch);
+      return number;
+    }
+    /** add an entry. It is up to the caller to check there is not one already */
+    void insert(std::uint64_t fingerprint, std::uint32_t number);
+    /** number of entries */
+    std::size_t size() const;
+    /** true while entries are still being moved out of the old table */
+    bool isMigrating() const;
+
+  private:
+    struct alignas(16) Slot {
+      std::uint64_t fingerprint;
+      std::uint32_t number;
+    };
+    typedef std::pmr::vector<Slot> slot_table;
+    /** slots moved to the new table on each insert while migrating */
+    static constexpr std::size_t migrateStep = 8;
+    static constexpr std::size_t initialSlots = 64;
+
+    template <typename Match>
+    static std::uint32_t findIn(const slot_table& table, std::uint64_t fingerprint, Match& isMatch)
+    {
+      if (table.empty()) return notFound;
+      std::size_t mask = table.size() - 1;
+      for (std::size_t i = firstSlot(fingerprint, mask); table[i].number != notFound; i = (i + 1) & mask)
+      {
+        if (table[i].fingerprint == fingerprint && isMatch(table[i].number)) return table[i].number;
+      }
+      return notFound;
+    }
+    /** where a fingerprint's probe starts. The low bits feed the sketch, so use the high ones */
+    static std::size_t firstSlot(std::uint64_t fingerprint, std::size_t mask);
+    static void place(slot_table& table, const Slot& slot);
+    /** move the next few old slots into the new table, dropping the old one when it is done */
+    void migrate();
+
+    slot_table slots;
+    slot_table oldSlots;
+    /** the next old slot to move */
+    std::size_t migrated;
+    std::size_t count;
+};
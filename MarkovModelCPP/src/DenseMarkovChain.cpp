@@ -0,0 +1,436 @@
+/*
+  ==============================================================================
+
+    DenseMarkovChain.cpp
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "DenseMarkovChain.h"
+#include "PitchSet.h"
+#include "NoteEvent.h"
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define MARKOV_DENSE_SSE2 1
+#endif
+
+template <typename State>
+BasicDenseMarkovChain<State>::BasicDenseMarkovChain(std::size_t _alphabetSize, unsigned long _maxOrder, unsigned long _denseOrders)
+: alphabetSize{_alphabetSize}, stride{(_alphabetSize + 3) & ~std::size_t{3}}, maxOrder{_maxOrder},
+  denseOrders{std::min(std::min(_denseOrders, maxDenseOrders), _maxOrder)}, sparse{_maxOrder}, useSparse{false},
+  orderOfLastMatch{0}, lastMatchWasSparse{false}, lastContext{}, lastObservation{-1}
+{
+  srand((int)time(NULL));
+  std::size_t rows = 1;
+  for (unsigned long order = 0; order <= denseOrders; ++order)
+  {
+    if (alphabetSize == 0) break;
+    counts[order].assign(rows * stride, 0);
+    totals[order].assign(rows, 0);
+    rows *= alphabetSize;
+  }
+  setOrders({});
+}
+
+template <typename State>
+BasicDenseMarkovChain<State>::~BasicDenseMarkovChain()
+{
+
+}
+
+template <typename State>
+void BasicDenseMarkovChain<State>::addObservationAllOrders(const state_sequence& prevState, state_single currentState)
+{
+  if (alphabetSize == 0 || traits::isBlank(currentState)) return;
+  // the sparse orders have no alphabet, so they learn whatever the tables have no room for
+  if (useSparse) sparse.addObservationAllOrders(prevState, currentState);
+  int obs = internSymbol(currentState);
+  if (obs == -1) return;
+  // the dense orders: ids of the most recent symbols, oldest first
+  int ids[maxDenseOrders];
+  unsigned long usable = 0;
+  while (usable < denseOrders && usable < prevState.size())
+  {
+    const state_single& s = prevState[prevState.size() - 1 - usable];
+    if (traits::isBlank(s)) break;
+    int id = internSymbol(s);
+    if (id == -1) break;
+    ids[denseOrders - 1 - usable] = id;
+    usable ++;
+  }
+  addToRow(0, 0, obs, 1);
+  for (unsigned long order = 1; order <= usable; ++order)
+  {
+    addToRow(order, rowIndex(ids + denseOrders - order, order), obs, 1);
+  }
+}
+
+template <typename State>
+State BasicDenseMarkovChain<State>::generateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice)
+{
+  // check for empty model
+  if (alphabetSize == 0 || totals[0][0] == 0) return traits::blank();
+  if (maxOrderWanted > (int) maxOrder) maxOrderWanted = maxOrder;
+  if (maxOrderWanted > (int) prevState.size()) maxOrderWanted = prevState.size();
+  state_single obs = traits::blank();
+  if (useSparse && maxOrderWanted > (int) denseOrders &&
+      sparse.tryGenerateObservation(prevState, maxOrderWanted, needChoice, obs))
+  {
+    orderOfLastMatch = sparse.getOrderOfLastMatch();
+    lastMatchWasSparse = true;
+    return obs;
+  }
+  lastMatchWasSparse = false;
+  int wanted = std::min(maxOrderWanted, (int) denseOrders);
+  int ids[maxDenseOrders];
+  int usable = 0;
+  while (usable < wanted)
+  {
+    const state_single& s = prevState[prevState.size() - 1 - usable];
+    if (traits::isBlank(s)) break;
+    int id = findSymbol(s);
+    if (id == -1) break;
+    ids[denseOrders - 1 - usable] = id;
+    usable ++;
+  }
+  for (int order = usable; order >= 0; --order)
+  {
+    if (order > 0 && !usesOrder(order)) continue;
+    const int* context = ids + denseOrders - order;
+    std::size_t row = rowIndex(context, order);
+    std::uint32_t total = totals[order][row];
+    // zero order ignores needChoice, as in MarkovChain
+    if (total == 0 || (order > 0 && needChoice && total < 2)) continue;
+    std::uint32_t choice = rand() % total;
+    int picked = (int) searchRow(counts[order].data() + row * stride, stride, choice);
+    orderOfLastMatch = order;
+    std::copy(context, context + order, lastContext);
+    lastObservation = picked;
+    return symbols[picked];
+  }
+  // everything has been removed by negative feedback
+  orderOfLastMatch = 0;
+  lastObservation = -1;
+  return traits::blank();
+}
+
+template <typename State>
+void BasicDenseMarkovChain<State>::setOrders(std::vector<unsigned long> _orders)
+{
+  std::sort(_orders.begin(), _orders.end());
+  _orders.erase(std::unique(_orders.begin(), _orders.end()), _orders.end());
+  if (_orders.size() > 0 && _orders[0] == 0) _orders.erase(_orders.begin());
+  orders = _orders;
+  // the sparse chain gets whatever is above the dense orders
+  std::vector<unsigned long> sparseOrders{};
+  if (orders.size() == 0)
+  {
+    for (unsigned long order = denseOrders + 1; order <= maxOrder; ++order) sparseOrders.push_back(order);
+  }
+  else
+  {
+    for (const unsigned long& order : orders) if (order > denseOrders) sparseOrders.push_back(order);
+  }
+  useSparse = sparseOrders.size() > 0;
+  if (useSparse) sparse.setOrders(sparseOrders);
+}
+
+template <typename State>
+std::vector<unsigned long> BasicDenseMarkovChain<State>::getOrders()
+{
+  return orders;
+}
+
+template <typename State>
+int BasicDenseMarkovChain<State>::getOrderOfLastMatch()
+{
+  return orderOfLastMatch;
+}
+
+template <typename State>
+std::pair<std::string, State> BasicDenseMarkovChain<State>::getLastMatch()
+{
+  if (lastMatchWasSparse) return sparse.getLastMatch();
+  if (lastObservation == -1) return state_and_observation{"0", traits::blank()};
+  if (orderOfLastMatch == 0) return state_and_observation{"0", symbols[lastObservation]};
+  std::string key = std::to_string(orderOfLastMatch) + ",";
+  for (int i = 0; i < orderOfLastMatch; ++i) key += traits::toString(symbols[lastContext[i]]) + ",";
+  return state_and_observation{key, symbols[lastObservation]};
+}
+
+template <typename State>
+void BasicDenseMarkovChain<State>::removeMapping(std::string state_key, State unwanted_option)
+{
+  int ids[maxDenseOrders];
+  int order = keyToIds(state_key, ids);
+  if (order > (int) denseOrders)
+  {
+    sparse.removeMapping(state_key, unwanted_option);
+    return;
+  }
+  int unwanted = findSymbol(unwanted_option);
+  if (order < 1 || unwanted == -1) return;
+  std::size_t row = rowIndex(ids, order);
+  std::uint32_t& count = counts[order][row * stride + unwanted];
+  totals[order][row] -= count;
+  count = 0;
+}
+
+template <typename State>
+void BasicDenseMarkovChain<State>::amplifyMapping(std::string state_key, State wanted_option)
+{
+  int ids[maxDenseOrders];
+  int order = keyToIds(state_key, ids);
+  if (order > (int) denseOrders)
+  {
+    sparse.amplifyMapping(state_key, wanted_option);
+    return;
+  }
+  int wanted = internSymbol(wanted_option);
+  if (order < 1 || wanted == -1) return;
+  std::size_t row = rowIndex(ids, order);
+  // match the number of othermappings as MarkovChain does
+  std::uint32_t othermappings = totals[order][row] - counts[order][row * stride + wanted];
+  addToRow(order, row, wanted, othermappings);
+}
+
+template <typename State>
+std::string BasicDenseMarkovChain<State>::toString()
+{
+  std::string s{""};
+  if (orders.size() > 0)
+  {
+    s += "orders:" + std::to_string(orders.size()) + ",";
+    for (const unsigned long& order : orders) s += std::to_string(order) + ",";
+    s += "\n";
+  }
+  for (unsigned long order = 1; order <= denseOrders && alphabetSize > 0; ++order)
+  {
+    for (std::size_t row = 0; row < totals[order].size(); ++row)
+    {
+      if (totals[order][row] == 0) continue;
+      // unpack the row index into its symbols, oldest first
+      std::string key{""};
+      std::size_t rest = row;
+      for (unsigned long i = 0; i < order; ++i)
+      {
+        key = traits::toString(symbols[rest % alphabetSize]) + "," + key;
+        rest /= alphabetSize;
+      }
+      s += std::to_string(order) + "," + key + ":" + std::to_string(totals[order][row]) + ",";
+      for (std::size_t obs = 0; obs < alphabetSize; ++obs)
+      {
+        for (std::uint32_t i = 0; i < counts[order][row * stride + obs]; ++i) s += traits::toString(symbols[obs]) + ",";
+      }
+      s += "\n";
+    }
+  }
+  if (useSparse)
+  {
+    // our own orders line covers the sparse orders too
+    std::string sparseModel = sparse.toString();
+    if (sparseModel.rfind("orders:", 0) == 0) sparseModel.erase(0, sparseModel.find('\n') + 1);
+    s += sparseModel;
+  }
+  return s;
+}
+
+template <typename State>
+bool BasicDenseMarkovChain<State>::fromString(const std::string& savedModel)
+{
+  std::string sparseModel{""};
+  std::vector<std::string> lines = MarkovChain::tokenise(savedModel, '\n');
+  for (const std::string& line : lines)
+  {
+    if (line.rfind("orders:", 0) == 0)
+    {
+      std::vector<unsigned long> savedOrders{};
+      std::vector<std::string> parts = MarkovChain::tokenise(line.substr(7), ',');
+      for (unsigned long i=1;i<parts.size();++i){ // 1 as first is the count
+        savedOrders.push_back(std::strtoul(parts[i].c_str(), nullptr, 10));
+      }
+      setOrders(savedOrders);
+      continue;
+    }
+    std::vector<std::string> k_v = MarkovChain::tokenise(line + ":", ':');
+    if (k_v.size() < 2) continue;
+    std::vector<std::string> key = MarkovChain::tokenise(k_v[0], ',');
+    if (key.size() < 2) continue;
+    unsigned long order = key.size() - 1;
+    if (order > denseOrders)
+    {
+      sparseModel += line + "\n";
+      continue;
+    }
+    int ids[maxDenseOrders];
+    bool valid = alphabetSize > 0;
+    for (unsigned long i = 0; i < order && valid; ++i)
+    {
+      ids[i] = internSymbol(traits::fromString(key[i + 1]));
+      valid = ids[i] != -1;
+    }
+    if (!valid) continue;
+    std::size_t row = rowIndex(ids, order);
+    std::vector<std::string> all_obs = MarkovChain::tokenise(k_v[1], ',');
+    for (unsigned long i=1;i<all_obs.size();++i){ // 1 as first is no. different observations
+      int obs = internSymbol(traits::fromString(all_obs[i]));
+      if (obs == -1) continue;
+      addToRow(order, row, obs, 1);
+      // the zero order counts are not saved, so rebuild them from order 1
+      if (order == 1) addToRow(0, 0, obs, 1);
+    }
+  }
+  if (useSparse && sparseModel.size() > 0) sparse.fromString(sparseModel);
+  return true;
+}
+
+template <typename State>
+void BasicDenseMarkovChain<State>::reset()
+{
+  for (unsigned long order = 0; order <= denseOrders; ++order)
+  {
+    std::fill(counts[order].begin(), counts[order].end(), 0);
+    std::fill(totals[order].begin(), totals[order].end(), 0);
+  }
+  symbols.clear();
+  symbolIds.clear();
+  sparse.reset();
+  orderOfLastMatch = 0;
+  lastObservation = -1;
+}
+
+template <typename State>
+long BasicDenseMarkovChain<State>::size()
+{
+  long contexts = 0;
+  for (unsigned long order = 1; order <= denseOrders && alphabetSize > 0; ++order)
+  {
+    contexts += std::count_if(totals[order].begin(), totals[order].end(), [](std::uint32_t total){ return total > 0; });
+  }
+  if (useSparse) contexts += sparse.size();
+  return contexts;
+}
+
+template <typename State>
+std::size_t BasicDenseMarkovChain<State>::getMemoryUsed()
+{
+  std::size_t bytes = 0;
+  for (unsigned long order = 0; order <= denseOrders; ++order)
+  {
+    bytes += (counts[order].size() + totals[order].size()) * sizeof(std::uint32_t);
+  }
+  return bytes;
+}
+
+template <typename State>
+float BasicDenseMarkovChain<State>::getRandomness()
+{
+  return this->randomness;
+}
+
+template <typename State>
+int BasicDenseMarkovChain<State>::internSymbol(const State& symbol)
+{
+  int id = findSymbol(symbol);
+  if (id != -1) return id;
+  if (symbols.size() >= alphabetSize) return -1;
+  symbols.push_back(symbol);
+  symbolIds[symbol] = (int) symbols.size() - 1;
+  return (int) symbols.size() - 1;
+}
+
+template <typename State>
+int BasicDenseMarkovChain<State>::findSymbol(const State& symbol)
+{
+  auto it = symbolIds.find(symbol);
+  if (it == symbolIds.end()) return -1;
+  return it->second;
+}
+
+template <typename State>
+std::size_t BasicDenseMarkovChain<State>::rowIndex(const int* ids, unsigned long order)
+{
+  std::size_t row = 0;
+  for (unsigned long i = 0; i < order; ++i) row = row * alphabetSize + ids[i];
+  return row;
+}
+
+template <typename State>
+void BasicDenseMarkovChain<State>::addToRow(unsigned long order, std::size_t row, int obs, std::uint32_t count)
+{
+  counts[order][row * stride + obs] += count;
+  totals[order][row] += count;
+}
+
+template <typename State>
+bool BasicDenseMarkovChain<State>::usesOrder(unsigned long order)
+{
+  if (orders.size() == 0) return true;
+  return std::binary_search(orders.begin(), orders.end(), order);
+}
+
+template <typename State>
+int BasicDenseMarkovChain<State>::keyToIds(const std::string& key, int* ids)
+{
+  // e.g. "2,a,b," -> [a, b]
+  std::vector<std::string> parts = MarkovChain::tokenise(key, ',');
+  if (parts.size() < 2) return -1;
+  unsigned long order = parts.size() - 1;
+  if (std::strtoul(parts[0].c_str(), nullptr, 10) != order) return -1;
+  if (order > denseOrders) return (int) order;
+  for (unsigned long i = 0; i < order; ++i)
+  {
+    ids[i] = findSymbol(traits::fromString(parts[i + 1]));
+    if (ids[i] == -1) return -1;
+  }
+  return (int) order;
+}
+
+template <typename State>
+std::size_t BasicDenseMarkovChain<State>::searchRow(const std::uint32_t* row, std::size_t length, std::uint32_t choice)
+{
+  std::size_t i = 0;
+#ifdef MARKOV_DENSE_SSE2
+  // running totals of four counts at a time: two shift-and-adds give the
+  // prefix sum within the register, then add the total carried from the left.
+  // totals stay below 2^31, so the signed compare is safe
+  const __m128i target = _mm_set1_epi32((int) choice);
+  __m128i carried = _mm_setzero_si128();
+  for (; i + 4 <= length; i += 4)
+  {
+    __m128i sums = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+    sums = _mm_add_epi32(sums, _mm_slli_si128(sums, 4));
+    sums = _mm_add_epi32(sums, _mm_slli_si128(sums, 8));
+    sums = _mm_add_epi32(sums, carried);
+    int over = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(sums, target)));
+    if (over != 0)
+    {
+      while ((over & 1) == 0)
+      {
+        over >>= 1;
+        i ++;
+      }
+      return i;
+    }
+    carried = _mm_shuffle_epi32(sums, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  choice -= (std::uint32_t) _mm_cvtsi128_si32(carried);
+#endif
+  for (; i < length; ++i)
+  {
+    if (choice < row[i]) return i;
+    choice -= row[i];
+  }
+  return length - 1;
+}
+
+template class BasicDenseMarkovChain<std::string>;
+template class BasicDenseMarkovChain<std::uint8_t>;
+template class BasicDenseMarkovChain<std::uint32_t>;
+template class BasicDenseMarkovChain<PitchSet>;
+template class BasicDenseMarkovChain<NoteEvent>;
@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    DenseMarkovChain.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "MarkovChain.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+/**
+ * A markov chain for small alphabets, such as MIDI velocities, where orders 0 to 2 are
+ * kept as dense count tables: one row of alphabetSize counts per context, so
+ * an order 1 model over 128 symbols is a 128 x 128 table. Finding a context is a
+ * single indexed load, and sampling runs a SIMD prefix sum along its row.
+ *
+ * Orders above the dense ones go into an ordinary BasicMarkovChain. The tables
+ * are allocated up front, alphabetSize^(denseOrders + 1) counts in all, so memory
+ * does not grow as it trains. Symbols beyond the first alphabetSize distinct ones
+ * have no place in the tables, so only the sparse orders learn them, and a chain
+ * without sparse orders ignores them.
+ *
+ * It saves in the same format as BasicMarkovChain, so the two can load each other's models.
+ */
+template <typename State>
+class BasicDenseMarkovChain {
+  public:
+    typedef State state_single;
+    typedef std::vector<State> state_sequence;
+    typedef std::pair<std::string, State> state_and_observation;
+    typedef StateTraits<State> traits;
+
+    /** the most orders that can be kept in dense tables */
+    static constexpr unsigned long maxDenseOrders = 2;
+
+    /**
+     * alphabetSize: how many distinct symbols the dense tables have room for. 0 allocates nothing,
+     * and the chain ignores everything it is sent.
+     * denseOrders: how many orders to keep in the tables, up to maxDenseOrders.
+     */
+    BasicDenseMarkovChain(std::size_t alphabetSize=128, unsigned long maxOrder=4, unsigned long denseOrders=maxDenseOrders);
+    ~BasicDenseMarkovChain();
+    /** add the sent observation following every order of prevState, as BasicMarkovChain::addObservationAllOrders */
+    void addObservationAllOrders(const state_sequence& prevState, state_single currentState);
+    /**
+     * generateObservation: as BasicMarkovChain::generateObservation, trying the sparse orders
+     * first, then the dense tables, then zero order.
+     */
+    state_single generateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice=false);
+    /** only use the sent orders, see BasicMarkovChain::setOrders */
+    void setOrders(std::vector<unsigned long> orders);
+    /** the orders set with setOrders - empty if all orders are in use */
+    std::vector<unsigned long> getOrders();
+    int getOrderOfLastMatch();
+    /** returns the key-value that was used to generate the last observation, in the BasicMarkovChain format */
+    state_and_observation getLastMatch();
+    void removeMapping(std::string state_key, state_single unwanted_option);
+    void amplifyMapping(std::string state_key, state_single wanted_option);
+    /** writes the dense tables out as BasicMarkovChain lines, followed by the sparse orders */
+    std::string toString();
+    bool fromString(const std::string& savedModel);
+    void reset();
+    /** return number of contexts in the chain */
+    long size();
+    /** bytes allocated for the dense tables */
+    std::size_t getMemoryUsed();
+
+    float randomness = 0.0f;
+
+    float getRandomness();
+  private:
+    /** returns the id of the sent symbol, adding it if needed. -1 if the alphabet is full */
+    int internSymbol(const state_single& symbol);
+    /** returns the id of the sent symbol or -1 if we have never seen it */
+    int findSymbol(const state_single& symbol);
+    /** row of the dense table for the sent order, ids are oldest first */
+    std::size_t rowIndex(const int* ids, unsigned long order);
+    /** adds count observations of obs to the row */
+    void addToRow(unsigned long order, std::size_t row, int obs, std::uint32_t count);
+    /** true if contexts of the sent order are matched */
+    bool usesOrder(unsigned long order);
+    /**
+     * parses a key in the BasicMarkovChain format into dense symbol ids.
+     * returns the order or -1 if the key is malformed or uses unknown symbols
+     */
+    int keyToIds(const std::string& key, int* ids);
+    /**
+     * index of the entry in a row where the running total first exceeds choice.
+     * uses SSE2 four counts at a time when available
+     */
+    static std::size_t searchRow(const std::uint32_t* row, std::size_t length, std::uint32_t choice);
+
+    std::size_t alphabetSize;
+    /** row length, padded to a multiple of four counts for the SIMD search */
+    std::size_t stride;
+    unsigned long maxOrder;
+    unsigned long denseOrders;
+    /** counts[order] is alphabetSize^order rows of stride counts */
+    std::vector<std::uint32_t> counts[maxDenseOrders + 1];
+    /** totals[order][row] is the sum of that row */
+    std::vector<std::uint32_t> totals[maxDenseOrders + 1];
+    /** the orders above the dense ones */
+    BasicMarkovChain<State> sparse;
+    bool useSparse;
+    std::vector<unsigned long> orders;
+    std::vector<State> symbols;
+    std::unordered_map<State, int, typename traits::hash> symbolIds;
+    int orderOfLastMatch;
+    /** what the last match was, so getLastMatch only builds a key when it is asked for */
+    bool lastMatchWasSparse;
+    int lastContext[maxDenseOrders];
+    int lastObservation;
+};
+
+typedef BasicDenseMarkovChain<std::string> DenseMarkovChain;
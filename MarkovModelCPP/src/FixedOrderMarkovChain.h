@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+    FixedOrderMarkovChain.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "StateTraits.h"
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+
+/**
+ * A variable order markov chain whose maximum order N is fixed at compile time,
+ * for the small models that are queried on every note (e.g. an order 4 velocity model).
+ *
+ * Contexts are std::array<State, N>, oldest first, as the memories kept by BasicMarkovManager.
+ * Symbols are interned to 16 bit ids, with 0 reserved, so every order of a context
+ * packs into the same one or two machine words: order k fills the k lowest slots and
+ * leaves the rest at zero. Hashing and backing off are unrolled at compile time.
+ *
+ * Continuations are kept as counts rather than a list of observations,
+ * which gives the same distribution as BasicMarkovChain in less memory.
+ * It lives in the header as it has to be compiled for every N.
+ */
+template <typename State, std::size_t N>
+class FixedOrderMarkovChain {
+  static_assert(N >= 1 && N <= 8, "FixedOrderMarkovChain packs contexts into at most two 64 bit words");
+  public:
+    typedef std::array<State, N> context_type;
+    typedef StateTraits<State> traits;
+
+    FixedOrderMarkovChain() : orderOfLastMatch{0}
+    {
+      srand((int)time(NULL));
+      reset();
+    }
+    /**
+     * add an observation following each order of the sent context, from 1 up to N
+     * or up to the most recent blank, as BasicMarkovChain::addObservationAllOrders.
+     * Symbols past the 65535th distinct one are ignored.
+     */
+    void addObservation(const context_type& prevState, const State& currentState)
+    {
+      if (traits::isBlank(currentState)) return;
+      symbol_id obs = internSymbol(currentState);
+      if (obs == 0) return;
+      std::array<symbol_id, N> ids{};
+      std::size_t usable = 0;
+      while (usable < N && !traits::isBlank(prevState[N - 1 - usable]))
+      {
+        ids[usable] = internSymbol(prevState[N - 1 - usable]);
+        if (ids[usable] == 0) break;
+        usable ++;
+      }
+      addContinuation(zeroOrder, obs);
+      key_type key{};
+      addOrders<1>(key, ids, usable, obs);
+    }
+    /**
+     * generate an observation from the longest matching order of prevState, backing off to
+     * shorter ones when there is no match or, if needChoice is set, only one observation.
+     * @return a state sampled from the model or a blank if the model is empty
+     */
+    State generateObservation(const context_type& prevState, bool needChoice=false)
+    {
+      if (zeroOrder.total == 0) return traits::blank();
+      // pack the whole context once, the shorter orders are just masks of it
+      std::array<symbol_id, N> ids{};
+      std::size_t usable = 0;
+      while (usable < N && !traits::isBlank(prevState[N - 1 - usable]))
+      {
+        if (!findSymbol(prevState[N - 1 - usable], ids[usable])) break;
+        usable ++;
+      }
+      key_type key{};
+      for (std::size_t i = 0; i < usable; ++i) setSlot(key, i, ids[i]);
+      State obs;
+      if (tryOrders<N>(key, usable, needChoice, obs)) return obs;
+      orderOfLastMatch = 0;
+      return symbols[pickContinuation(zeroOrder)];
+    }
+    /** return the order of the last match generated from generateObservation */
+    int getOrderOfLastMatch()
+    {
+      return orderOfLastMatch;
+    }
+    /** return number of contexts in the chain */
+    long size()
+    {
+      return model.size();
+    }
+    /** wipe the chain */
+    void reset()
+    {
+      model.clear();
+      symbols.assign(1, traits::blank()); // id 0 is reserved
+      symbolIds.clear();
+      zeroOrder = Continuations{};
+    }
+
+  private:
+    typedef std::uint16_t symbol_id;
+    static constexpr std::size_t bitsPerSymbol = 16;
+    static constexpr std::size_t symbolsPerWord = 64 / bitsPerSymbol;
+    static constexpr std::size_t words = (N + symbolsPerWord - 1) / symbolsPerWord;
+    typedef std::array<std::uint64_t, words> key_type;
+
+    struct Continuations {
+      std::vector<std::pair<symbol_id, std::uint32_t>> counts;
+      std::uint32_t total = 0;
+    };
+
+    struct KeyHash {
+      std::size_t operator()(const key_type& key) const
+      {
+        return hashWords(key, std::make_index_sequence<words>{});
+      }
+      template <std::size_t... I>
+      static constexpr std::uint64_t hashWords(const key_type& key, std::index_sequence<I...>)
+      {
+        std::uint64_t hash = 0;
+        ((hash = mix(hash ^ key[I])), ...);
+        return hash;
+      }
+      static constexpr std::uint64_t mix(std::uint64_t x)
+      {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+      }
+    };
+
+    static void setSlot(key_type& key, std::size_t slot, symbol_id id)
+    {
+      key[slot / symbolsPerWord] |= std::uint64_t{id} << ((slot % symbolsPerWord) * bitsPerSymbol);
+    }
+    /** the key for a shorter order: clear all the slots from 'order' up */
+    template <std::size_t Order>
+    static constexpr key_type truncate(const key_type& key)
+    {
+      key_type shorter = key;
+      for (std::size_t word = 0; word < words; ++word)
+      {
+        const std::size_t first = word * symbolsPerWord;
+        if (first >= Order) shorter[word] = 0;
+        else if (Order - first < symbolsPerWord) shorter[word] &= (std::uint64_t{1} << ((Order - first) * bitsPerSymbol)) - 1;
+      }
+      return shorter;
+    }
+
+    template <std::size_t Order>
+    void addOrders(key_type& key, const std::array<symbol_id, N>& ids, std::size_t usable, symbol_id obs)
+    {
+      if (Order > usable) return;
+      setSlot(key, Order - 1, ids[Order - 1]);
+      addContinuation(model[key], obs);
+      if constexpr (Order < N) addOrders<Order + 1>(key, ids, usable, obs);
+    }
+
+    template <std::size_t Order>
+    bool tryOrders(const key_type& key, std::size_t usable, bool needChoice, State& obs)
+    {
+      if (Order <= usable)
+      {
+        auto found = model.find(truncate<Order>(key));
+        if (found != model.end() && found->second.total > 0 && (!needChoice || found->second.total > 1))
+        {
+          orderOfLastMatch = Order;
+          obs = symbols[pickContinuation(found->second)];
+          return true;
+        }
+      }
+      if constexpr (Order > 1) return tryOrders<Order - 1>(key, usable, needChoice, obs);
+      else return false;
+    }
+
+    static void addContinuation(Continuations& continuations, symbol_id obs)
+    {
+      continuations.total ++;
+      for (auto& count : continuations.counts)
+      {
+        if (count.first == obs)
+        {
+          count.second ++;
+          return;
+        }
+      }
+      continuations.counts.push_back({obs, 1});
+    }
+
+    static symbol_id pickContinuation(const Continuations& continuations)
+    {
+      std::uint32_t choice = rand() % continuations.total;
+      for (const auto& count : continuations.counts)
+      {
+        if (choice < count.second) return count.first;
+        choice -= count.second;
+      }
+      return continuations.counts.back().first;
+    }
+
+    /** returns the id of the sent symbol, adding it if needed. 0 if the table is full */
+    symbol_id internSymbol(const State& symbol)
+    {
+      symbol_id id;
+      if (findSymbol(symbol, id)) return id;
+      if (symbols.size() > UINT16_MAX) return 0;
+      id = (symbol_id) symbols.size();
+      symbols.push_back(symbol);
+      symbolIds[symbol] = id;
+      return id;
+    }
+
+    bool findSymbol(const State& symbol, symbol_id& id)
+    {
+      auto it = symbolIds.find(symbol);
+      if (it == symbolIds.end()) return false;
+      id = it->second;
+      return true;
+    }
+
+    std::unordered_map<key_type, Continuations, KeyHash> model;
+    Continuations zeroOrder;
+    std::vector<State> symbols;
+    std::unordered_map<State, symbol_id, typename traits::hash> symbolIds;
+    int orderOfLastMatch;
+};
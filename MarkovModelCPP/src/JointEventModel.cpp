@@ -0,0 +1,282 @@
+/*
+  ==============================================================================
+
+    JointEventModel.cpp
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "JointEventModel.h"
+#include <algorithm>
+
+/** how the reserve is shared out: the joint and pitch models train the same orders, attributesGivenPitch only the first */
+static std::size_t sequenceShare(std::size_t bytes)
+{
+  return bytes / 5 * 2;
+}
+
+static std::size_t attributesShare(std::size_t bytes)
+{
+  return bytes / 5;
+}
+
+static const std::string pitchSection = "#PITCHMODEL#\n";
+static const std::string attributesSection = "#ATTRIBUTES#\n";
+
+JointEventModel::JointEventModel(unsigned long _maxOrder, ModelEngine engine)
+  : joint{makeMarkovEngine<NoteEvent>(supportedEngine(engine), _maxOrder)},
+  pitch{makeMarkovEngine<PitchSet>(supportedEngine(engine), _maxOrder)},
+  attributesGivenPitch{1}, maxOrder{_maxOrder}, exactOrderLimit{0}, reservedBytes{0},
+  factorised{false}, orderOfLastEvent{0}, contextCount{0}
+{
+  inputMemory.events.assign(maxOrder, StateTraits<NoteEvent>::blank());
+  inputMemory.pitches.assign(maxOrder, PitchSet{});
+  outputMemory.assign(maxOrder, StateTraits<NoteEvent>::blank());
+  pitchOutputMemory.assign(maxOrder, PitchSet{});
+  pitchContext.assign(1, StateTraits<NoteEvent>::blank());
+}
+
+void JointEventModel::putEvent(const NoteEvent& event)
+{
+  std::lock_guard<std::mutex> lock{mtx};
+  train(event, inputMemory);
+}
+
+void JointEventModel::putTransposedEvent(const NoteEvent& event, int semitones)
+{
+  NoteEvent moved = event;
+  moved.pitches = event.pitches.shifted(semitones);
+  std::lock_guard<std::mutex> lock{mtx};
+  // it would splice the copies into the one sequence it learns
+  if (!joint->usesSentContext()) return;
+  auto found = transposedInputMemories.find(semitones);
+  if (found == transposedInputMemories.end())
+  {
+    InputMemory memory{};
+    memory.events.assign(maxOrder, StateTraits<NoteEvent>::blank());
+    memory.pitches.assign(maxOrder, PitchSet{});
+    found = transposedInputMemories.emplace(semitones, memory).first;
+  }
+  if (moved.pitches.size() != event.pitches.size())
+  {
+    found->second.events.assign(maxOrder, StateTraits<NoteEvent>::blank());
+    found->second.pitches.assign(maxOrder, PitchSet{});
+    return;
+  }
+  train(moved, found->second);
+}
+
+void JointEventModel::train(const NoteEvent& event, InputMemory& memory)
+{
+  joint->addObservationAllOrders(memory.events, event);
+  addToMemory(memory.events, event);
+  if (factorised)
+  {
+    pitch->addObservationAllOrders(memory.pitches, event.pitches);
+    attributesGivenPitch.addObservation({pitchOnly(event.pitches)}, event);
+  }
+  // the pitch memory follows along even when it is not trained,
+  // so turning factorised backoff on picks up from here
+  addToMemory(memory.pitches, event.pitches);
+  contextCount.store(joint->size(), std::memory_order_relaxed);
+}
+
+bool JointEventModel::tryPutEvent(const NoteEvent& event)
+{
+  std::unique_lock<std::mutex> lock{mtx, std::try_to_lock};
+  if (!lock.owns_lock()) return false;
+  train(event, inputMemory);
+  return true;
+}
+
+NoteEvent JointEventModel::getEvent(bool needChoices)
+{
+  std::lock_guard<std::mutex> lock{mtx};
+  return generate(needChoices);
+}
+
+bool JointEventModel::tryGetEvent(NoteEvent& event, bool needChoices)
+{
+  std::unique_lock<std::mutex> lock{mtx, std::try_to_lock};
+  if (!lock.owns_lock()) return false;
+  event = generate(needChoices);
+  return true;
+}
+
+NoteEvent JointEventModel::generate(bool needChoices)
+{
+  NoteEvent event = joint->generateObservation(outputMemory, outputMemory.size(), needChoices);
+  orderOfLastEvent = joint->getOrderOfLastMatch();
+  if (factorised && orderOfLastEvent < minJointOrder)
+  {
+    PitchSet pitches{};
+    if (pitch->tryGenerateObservation(pitchOutputMemory, pitchOutputMemory.size(), needChoices, pitches) &&
+        pitch->getOrderOfLastMatch() > orderOfLastEvent)
+    {
+      NoteEvent withAttributes{};
+      pitchContext[0] = pitchOnly(pitches);
+      if (attributesGivenPitch.tryGenerateObservation(pitchContext, 1, false, withAttributes))
+      {
+        event = withAttributes;
+        orderOfLastEvent = pitch->getOrderOfLastMatch();
+      }
+    }
+  }
+  addToMemory(outputMemory, event);
+  addToMemory(pitchOutputMemory, event.pitches);
+  return event;
+}
+
+int JointEventModel::getOrderOfLastEvent()
+{
+  return orderOfLastEvent;
+}
+
+void JointEventModel::setFactorisedBackoff(bool _factorised)
+{
+  std::lock_guard<std::mutex> lock{mtx};
+  factorised = _factorised;
+}
+
+bool JointEventModel::getFactorisedBackoff()
+{
+  return factorised;
+}
+
+float JointEventModel::getRandomness()
+{
+  std::lock_guard<std::mutex> lock{mtx};
+  return joint->getRandomness();
+}
+
+void JointEventModel::setRandomness(float randomness)
+{
+  std::lock_guard<std::mutex> lock{mtx};
+  joint->setRandomness(randomness);
+}
+
+void JointEventModel::setEngine(ModelEngine engine)
+{
+  engine = supportedEngine(engine);
+  std::lock_guard<std::mutex> lock{mtx};
+  if (engine == joint->getType()) return;
+  std::unique_ptr<BasicMarkovEngine<NoteEvent>> nextJoint = makeMarkovEngine<NoteEvent>(engine, maxOrder);
+  std::unique_ptr<BasicMarkovEngine<PitchSet>> nextPitch = makeMarkovEngine<PitchSet>(engine, maxOrder);
+  nextJoint->setRandomness(joint->getRandomness());
+  if (exactOrderLimit > 0)
+  {
+    nextJoint->setExactOrderLimit(exactOrderLimit);
+    nextPitch->setExactOrderLimit(exactOrderLimit);
+  }
+  if (reservedBytes > 0)
+  {
+    nextJoint->reserveMemory(sequenceShare(reservedBytes));
+    nextPitch->reserveMemory(sequenceShare(reservedBytes));
+  }
+  if (joint->usesSentContext() && nextJoint->usesSentContext())
+  {
+    nextJoint->fromString(joint->toString());
+    nextPitch->fromString(pitch->toString());
+  }
+  joint = std::move(nextJoint);
+  pitch = std::move(nextPitch);
+  contextCount.store(joint->size(), std::memory_order_relaxed);
+}
+
+ModelEngine JointEventModel::getEngine()
+{
+  std::lock_guard<std::mutex> lock{mtx};
+  return joint->getType();
+}
+
+void JointEventModel::reset()
+{
+  std::lock_guard<std::mutex> lock{mtx};
+  joint->reset();
+  pitch->reset();
+  attributesGivenPitch.reset();
+  inputMemory.events.assign(maxOrder, StateTraits<NoteEvent>::blank());
+  inputMemory.pitches.assign(maxOrder, PitchSet{});
+  transposedInputMemories.clear();
+  outputMemory.assign(maxOrder, StateTraits<NoteEvent>::blank());
+  pitchOutputMemory.assign(maxOrder, PitchSet{});
+  orderOfLastEvent = 0;
+  contextCount.store(0, std::memory_order_relaxed);
+}
+
+void JointEventModel::reserveMemory(std::size_t bytes)
+{
+  std::lock_guard<std::mutex> lock{mtx};
+  reservedBytes = bytes;
+  joint->reserveMemory(sequenceShare(bytes));
+  pitch->reserveMemory(sequenceShare(bytes));
+  attributesGivenPitch.reserveMemory(attributesShare(bytes));
+}
+
+std::size_t JointEventModel::memoryFor(std::size_t events, unsigned long exactOrders)
+{
+  // enough that each model's share covers what it needs
+  std::size_t sequences = std::max(BasicMarkovChain<NoteEvent>::memoryFor(events, exactOrders),
+                                   BasicMarkovChain<PitchSet>::memoryFor(events, exactOrders));
+  return std::max((sequences + 1) / 2 * 5, BasicMarkovChain<NoteEvent>::memoryFor(events, 1) * 5);
+}
+
+void JointEventModel::setExactOrderLimit(unsigned long order)
+{
+  std::lock_guard<std::mutex> lock{mtx};
+  exactOrderLimit = order;
+  joint->setExactOrderLimit(order);
+  pitch->setExactOrderLimit(order);
+}
+
+std::string JointEventModel::getModelAsString()
+{
+  std::lock_guard<std::mutex> lock{mtx};
+  return joint->toString() + pitchSection + pitch->toString() + attributesSection + attributesGivenPitch.toString();
+}
+
+bool JointEventModel::setupModelFromString(const std::string& savedModel)
+{
+  std::lock_guard<std::mutex> lock{mtx};
+  std::size_t pitchStart = savedModel.find(pitchSection);
+  std::size_t attributesStart = savedModel.find(attributesSection);
+  bool loaded = joint->fromString(savedModel.substr(0, pitchStart));
+  contextCount.store(joint->size(), std::memory_order_relaxed);
+  if (!loaded) return false;
+  // the factorised models are only there if they were trained
+  if (pitchStart == std::string::npos || attributesStart == std::string::npos || attributesStart < pitchStart) return true;
+  pitchStart += pitchSection.size();
+  pitch->fromString(savedModel.substr(pitchStart, attributesStart - pitchStart));
+  attributesGivenPitch.fromString(savedModel.substr(attributesStart + attributesSection.size()));
+  return true;
+}
+
+long JointEventModel::size()
+{
+  return contextCount.load(std::memory_order_relaxed);
+}
+
+ModelEngine JointEventModel::supportedEngine(ModelEngine engine)
+{
+  return engine == ModelEngine::denseMatrix ? ModelEngine::markovChain : engine;
+}
+
+NoteEvent JointEventModel::pitchOnly(const PitchSet& pitches)
+{
+  NoteEvent event{};
+  event.pitches = pitches;
+  return event;
+}
+
+void JointEventModel::addToMemory(event_sequence& memory, const NoteEvent& event)
+{
+  for (std::size_t i = 1; i < memory.size(); ++i) memory[i - 1] = memory[i];
+  memory[memory.size() - 1] = event;
+}
+
+void JointEventModel::addToMemory(std::vector<PitchSet>& memory, const PitchSet& pitches)
+{
+  for (std::size_t i = 1; i < memory.size(); ++i) memory[i - 1] = memory[i];
+  memory[memory.size() - 1] = pitches;
+}
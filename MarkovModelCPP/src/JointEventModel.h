@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    JointEventModel.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "MarkovChain.h"
+#include "MarkovEngine.h"
+#include "NoteEvent.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * One markov model for whole NoteEvents, in place of a manager per attribute.
+ * Training and generating a chord is one lookup under one lock, and the
+ * attributes that come out belong together.
+ *
+ * Joint states are rarer than any one attribute, so long joint contexts match less often.
+ * With factorised backoff on, when the joint model can only match a short context, the
+ * pitch comes from a model of pitches alone, which matches longer contexts, and the
+ * other attributes are drawn from those seen with that pitch.
+ */
+class JointEventModel {
+  public:
+    typedef std::vector<NoteEvent> event_sequence;
+
+    /** as BasicMarkovManager, maxOrder is the longest context used for the joint and pitch models */
+    JointEventModel(unsigned long maxOrder=100, ModelEngine engine=ModelEngine::markovChain);
+    /** learn an event following the ones sent before it */
+    void putEvent(const NoteEvent& event);
+    /**
+     * as putEvent, but returns false straight away, learning nothing, if another thread
+     * has the model, e.g. a TranspositionAugmenter worker. For the audio thread, which
+     * should keep the event and try again rather than wait
+     */
+    bool tryPutEvent(const NoteEvent& event);
+    /**
+     * learn a copy of the event moved by the sent number of semitones, following the copies
+     * moved by the same amount before it, as if it had been played in that key.
+     * A copy with notes outside the MIDI range is skipped and breaks its context.
+     * See TranspositionAugmenter, which calls this off the audio thread
+     */
+    void putTransposedEvent(const NoteEvent& event, int semitones);
+    /**
+     * generate an event following the ones generated before it
+     * @param needChoices: see BasicMarkovManager::getEvent
+     * Once the model has been trained this does not allocate, so it can run on the audio thread
+     */
+    NoteEvent getEvent(bool needChoices=true);
+    /** as getEvent, but returns false straight away, leaving event alone, if another thread has the model */
+    bool tryGetEvent(NoteEvent& event, bool needChoices=true);
+    /** the order of the match behind the last generated event */
+    int getOrderOfLastEvent();
+    /** turn the factorised backoff on or off, it is off by default */
+    void setFactorisedBackoff(bool factorised);
+    bool getFactorisedBackoff();
+    float getRandomness();
+    void setRandomness(float randomness);
+    /**
+     * switch the engine behind the joint and pitch models, as BasicMarkovManager::setEngine.
+     * The suffix automaton learns one sequence, so it does not learn transposed copies.
+     * The dense engine's tables only have room for a small alphabet, which joint events and
+     * chords outgrow almost at once, so asking for it gives the markov chain, as does the constructor
+     */
+    void setEngine(ModelEngine engine);
+    ModelEngine getEngine();
+    /** wipe the models and the input and output memories */
+    void reset();
+    /**
+     * see BasicMarkovManager::reserveMemory. The joint and pitch models, which train
+     * the same orders, get two fifths each, and attributesGivenPitch the rest
+     */
+    void reserveMemory(std::size_t bytes);
+    /**
+     * bytes for reserveMemory so that training 'events' events at 'exactOrders' exact orders
+     * stays within the reserve, see BasicMarkovChain::memoryFor
+     */
+    static std::size_t memoryFor(std::size_t events, unsigned long exactOrders);
+    /** see BasicMarkovManager::setExactOrderLimit */
+    void setExactOrderLimit(unsigned long order);
+    /** the joint model, then the pitch model and the attributes given pitch */
+    std::string getModelAsString();
+    bool setupModelFromString(const std::string& savedModel);
+    /** return number of joint contexts. Does not lock, so it can be read from any thread */
+    long size();
+
+  private:
+    /** the event with only the pitches, which is the context for attributesGivenPitch */
+    static NoteEvent pitchOnly(const PitchSet& pitches);
+    /** the engine to use when the sent one is asked for */
+    static ModelEngine supportedEngine(ModelEngine engine);
+    /** the body of getEvent, called with mtx held */
+    NoteEvent generate(bool needChoices);
+    /** what the models were last trained on, for one transposition */
+    struct InputMemory {
+      event_sequence events;
+      std::vector<PitchSet> pitches;
+    };
+    /** train all the models on event following memory, then add it to memory */
+    void train(const NoteEvent& event, InputMemory& memory);
+    static void addToMemory(event_sequence& memory, const NoteEvent& event);
+    static void addToMemory(std::vector<PitchSet>& memory, const PitchSet& pitches);
+
+    /** a joint match shorter than this falls back to the factorised models, if they do better */
+    static constexpr int minJointOrder = 2;
+
+    std::unique_ptr<BasicMarkovEngine<NoteEvent>> joint;
+    std::unique_ptr<BasicMarkovEngine<PitchSet>> pitch;
+    /** order 1 model from an event's pitches to the whole event */
+    BasicMarkovChain<NoteEvent> attributesGivenPitch;
+    unsigned long maxOrder;
+    /** the settings sent so far, for when the engine is switched */
+    unsigned long exactOrderLimit;
+    std::size_t reservedBytes;
+    InputMemory inputMemory;
+    /** one per transposition used with putTransposedEvent */
+    std::unordered_map<int, InputMemory> transposedInputMemories;
+    event_sequence outputMemory;
+    std::vector<PitchSet> pitchOutputMemory;
+    /** the context for attributesGivenPitch when generating, kept so that getEvent does not allocate */
+    event_sequence pitchContext;
+    bool factorised;
+    int orderOfLastEvent;
+    /** the joint model's size, refreshed under mtx whenever it changes */
+    std::atomic<long> contextCount;
+    std::mutex mtx;
+};
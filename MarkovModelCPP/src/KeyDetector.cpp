@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    KeyDetector.cpp
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "KeyDetector.h"
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+  #include <xmmintrin.h>
+  #define MARKOV_KEY_SSE 1
+#endif
+
+/** Krumhansl and Kessler's ratings of how well each pitch class above the tonic fits a key */
+static const double majorProfile[12] = {6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88};
+static const double minorProfile[12] = {6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17};
+/** past this, the weights of newer notes are folded into the histogram before they overflow */
+static const double maxWeight = 1e18;
+
+KeyDetector::KeyDetector(double _sampleRate, double windowSeconds) : sampleRate{_sampleRate}, window{windowSeconds}
+{
+  for (int key = 0; key < numKeys; ++key)
+  {
+    const double* profile = key < 12 ? majorProfile : minorProfile;
+    double mean = 0;
+    for (int i = 0; i < 12; ++i) mean += profile[i] / 12;
+    double length = 0;
+    for (int i = 0; i < 12; ++i) length += (profile[i] - mean) * (profile[i] - mean);
+    length = std::sqrt(length);
+    for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+    {
+      profiles[pitchClass][key] = (float) ((profile[(pitchClass - key % 12 + 12) % 12] - mean) / length);
+    }
+  }
+  reset();
+}
+
+void KeyDetector::setSampleRate(double _sampleRate)
+{
+  if (_sampleRate > 0) sampleRate = _sampleRate;
+}
+
+void KeyDetector::setWindow(double seconds)
+{
+  if (seconds > 0) window = seconds;
+}
+
+double KeyDetector::getWindow() const
+{
+  return window;
+}
+
+void KeyDetector::addNote(int note, unsigned long time)
+{
+  if (note < 0 || note > 127) return;
+  if (!timeSet)
+  {
+    referenceTime = time;
+    timeSet = true;
+  }
+  double weight = std::exp2(((double) time - (double) referenceTime) / (window * sampleRate));
+  if (weight > maxWeight)
+  {
+    rebase(time);
+    weight = 1.0;
+  }
+  histogram[note % 12] += (float) weight;
+}
+
+int KeyDetector::detectKey()
+{
+  double mean = 0;
+  for (int i = 0; i < 12; ++i) mean += histogram[i] / 12.0;
+  double length = 0;
+  for (int i = 0; i < 12; ++i) length += (histogram[i] - mean) * (histogram[i] - mean);
+  // nothing played, or every pitch class alike
+  if (length <= 0)
+  {
+    scores.fill(0.0f);
+    return -1;
+  }
+  // the profiles have no mean, so the histogram's mean drops out of the dot products
+#ifdef MARKOV_KEY_SSE
+  __m128 sums[numKeys / 4];
+  for (int j = 0; j < numKeys / 4; ++j) sums[j] = _mm_setzero_ps();
+  for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+  {
+    __m128 weight = _mm_set1_ps(histogram[pitchClass]);
+    for (int j = 0; j < numKeys / 4; ++j) sums[j] = _mm_add_ps(sums[j], _mm_mul_ps(weight, _mm_load_ps(profiles[pitchClass] + 4 * j)));
+  }
+  for (int j = 0; j < numKeys / 4; ++j) _mm_storeu_ps(scores.data() + 4 * j, sums[j]);
+#else
+  scores.fill(0.0f);
+  for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+  {
+    for (int key = 0; key < numKeys; ++key) scores[key] += histogram[pitchClass] * profiles[pitchClass][key];
+  }
+#endif
+  float scale = (float) (1.0 / std::sqrt(length));
+  for (float& score : scores) score *= scale;
+  return (int) (std::max_element(scores.begin(), scores.end()) - scores.begin());
+}
+
+const std::array<float, KeyDetector::numKeys>& KeyDetector::getScores() const
+{
+  return scores;
+}
+
+void KeyDetector::setKey(int key)
+{
+  reset();
+  if (key < 0 || key >= numKeys) return;
+  const double* profile = key < 12 ? majorProfile : minorProfile;
+  for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+  {
+    histogram[pitchClass] = (float) profile[(pitchClass - key % 12 + 12) % 12];
+  }
+}
+
+void KeyDetector::reset()
+{
+  std::fill(std::begin(histogram), std::end(histogram), 0.0f);
+  scores.fill(0.0f);
+  referenceTime = 0;
+  timeSet = false;
+}
+
+std::string KeyDetector::toString() const
+{
+  float largest = *std::max_element(std::begin(histogram), std::end(histogram));
+  std::string s{""};
+  for (const float& weight : histogram) s += std::to_string(largest > 0 ? weight / largest : 0.0f) + ",";
+  return s;
+}
+
+bool KeyDetector::fromString(const std::string& saved)
+{
+  float weights[12];
+  const char* start = saved.c_str();
+  for (int i = 0; i < 12; ++i)
+  {
+    char* end;
+    weights[i] = std::strtof(start, &end);
+    if (end == start || *end != ',' || !(weights[i] >= 0)) return false;
+    start = end + 1;
+  }
+  reset();
+  std::copy(std::begin(weights), std::end(weights), std::begin(histogram));
+  return true;
+}
+
+void KeyDetector::rebase(unsigned long time)
+{
+  float fold = (float) std::exp2(((double) referenceTime - (double) time) / (window * sampleRate));
+  for (float& weight : histogram) weight *= fold;
+  referenceTime = time;
+}
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    KeyDetector.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <string>
+
+/**
+ * Follows the key of what is being played. Each note adds to a histogram of the 12 pitch
+ * classes, where older notes count for less, halving every window seconds, so the key
+ * can move when the player modulates. detectKey correlates the histogram with the
+ * Krumhansl-Kessler profile of each of the 24 keys and picks the best fit.
+ *
+ * Adding a note is O(1): rather than decaying every bin, newer notes are weighted up,
+ * which comes to the same thing as correlation ignores scale. detectKey does all 24
+ * correlations at once, four keys to a SIMD register, and is meant to run once per block.
+ * Nothing allocates, so both are safe on the audio thread.
+ *
+ * Keys are numbered as in ScaleTables: 0 to 11 are C major to B major, 12 to 23 C minor to B minor.
+ */
+class KeyDetector {
+  public:
+    static constexpr int numKeys = 24;
+
+    KeyDetector(double sampleRate=44100.0, double windowSeconds=30.0);
+    void setSampleRate(double sampleRate);
+    /** how long it takes a note to count half as much, ignored if not positive */
+    void setWindow(double seconds);
+    double getWindow() const;
+    /** count a note played at the sent time in samples. Times should not go backwards */
+    void addNote(int note, unsigned long time);
+    /** the key that fits the notes so far best, -1 if there have not been any */
+    int detectKey();
+    /** the correlation of each key with the notes, from the last detectKey */
+    const std::array<float, numKeys>& getScores() const;
+    /** start again from the sent key's profile, as if much had been played in it */
+    void setKey(int key);
+    /** forget every note */
+    void reset();
+    /** writes the pitch class weights, scaled so the largest is 1 */
+    std::string toString() const;
+    /** reads what toString wrote. returns false and leaves things as they were if it can't */
+    bool fromString(const std::string& saved);
+
+  private:
+    /** fold the weighting of newer notes into the histogram, so it starts again from time */
+    void rebase(unsigned long time);
+
+    double sampleRate;
+    double window;
+    /** the histogram bins, which are weighted relative to referenceTime */
+    alignas(16) float histogram[12];
+    unsigned long referenceTime;
+    /** false until the first note after a reset or a load sets referenceTime */
+    bool timeSet;
+    /** each key's profile with the mean taken out and scaled to unit length, twelve rows of one column per key */
+    alignas(16) float profiles[12][numKeys];
+    std::array<float, numKeys> scores;
+};
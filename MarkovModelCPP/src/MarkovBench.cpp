@@ -0,0 +1,190 @@
+#include "MarkovChain.h"
+#include "FixedOrderMarkovChain.h"
+#include "DenseMarkovChain.h"
+#include "MarkovEngine.h"
+
+#include <iostream>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+/**
+ * Compares the dynamic BasicMarkovChain with FixedOrderMarkovChain and BasicDenseMarkovChain
+ * on an order 4 velocity model, the kind of small model that is queried for every note.
+ * Build with optimisation on, e.g. g++ -O2 -std=c++17 MarkovBench.cpp MarkovChain.cpp ContextSketch.cpp ContextTable.cpp DenseMarkovChain.cpp
+ * SuffixAutomaton.cpp MarkovEngine.cpp RealtimeLog.cpp -pthread
+ */
+
+const std::size_t order = 4;
+const int trainEvents = 100000;
+const int generateEvents = 1000000;
+
+/** velocities that wander around in steps, like a player would */
+std::vector<std::uint8_t> makeVelocities(int count)
+{
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<> step(-2, 2);
+    std::vector<std::uint8_t> velocities{};
+    int velocity = 64;
+    for (auto i=0; i<count; ++i){
+        velocity += step(gen) * 4;
+        if (velocity < 20) velocity = 20;
+        if (velocity > 124) velocity = 124;
+        velocities.push_back((std::uint8_t) velocity);
+    }
+    return velocities;
+}
+
+double millisSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, std::string what, int events, double millis)
+{
+    std::cout << name << " " << what << ": " << millis << "ms, "
+              << (events / millis) * 1000 << " events per second" << std::endl;
+}
+
+void benchDynamic(const std::vector<std::uint8_t>& velocities)
+{
+    BasicMarkovChain<std::uint8_t> chain{order};
+    std::vector<std::uint8_t> memory(order, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (const std::uint8_t& v : velocities){
+        chain.addObservationAllOrders(memory, v);
+        memory.erase(memory.begin());
+        memory.push_back(v);
+    }
+    report("dynamic", "train", trainEvents, millisSince(start));
+    long total = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto i=0; i<generateEvents; ++i){
+        std::uint8_t v = chain.generateObservation(memory, order, true);
+        memory.erase(memory.begin());
+        memory.push_back(v);
+        total += chain.getOrderOfLastMatch();
+    }
+    report("dynamic", "generate", generateEvents, millisSince(start));
+    std::cout << "dynamic mean order " << (double) total / generateEvents << std::endl;
+}
+
+void benchFixed(const std::vector<std::uint8_t>& velocities)
+{
+    FixedOrderMarkovChain<std::uint8_t, order> chain{};
+    std::array<std::uint8_t, order> memory{};
+    auto start = std::chrono::steady_clock::now();
+    for (const std::uint8_t& v : velocities){
+        chain.addObservation(memory, v);
+        std::rotate(memory.begin(), memory.begin() + 1, memory.end());
+        memory[order - 1] = v;
+    }
+    report("fixed", "train", trainEvents, millisSince(start));
+    long total = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto i=0; i<generateEvents; ++i){
+        std::uint8_t v = chain.generateObservation(memory, true);
+        std::rotate(memory.begin(), memory.begin() + 1, memory.end());
+        memory[order - 1] = v;
+        total += chain.getOrderOfLastMatch();
+    }
+    report("fixed", "generate", generateEvents, millisSince(start));
+    std::cout << "fixed mean order " << (double) total / generateEvents << std::endl;
+}
+
+void benchDense(const std::vector<std::uint8_t>& velocities)
+{
+    BasicDenseMarkovChain<std::uint8_t> chain{128, order};
+    std::vector<std::uint8_t> memory(order, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (const std::uint8_t& v : velocities){
+        chain.addObservationAllOrders(memory, v);
+        memory.erase(memory.begin());
+        memory.push_back(v);
+    }
+    report("dense", "train", trainEvents, millisSince(start));
+    long total = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto i=0; i<generateEvents; ++i){
+        std::uint8_t v = chain.generateObservation(memory, order, true);
+        memory.erase(memory.begin());
+        memory.push_back(v);
+        total += chain.getOrderOfLastMatch();
+    }
+    report("dense", "generate", generateEvents, millisSince(start));
+    std::cout << "dense mean order " << (double) total / generateEvents << std::endl;
+}
+
+/**
+ * a long melody at order 8 on the dynamic chain, where nearly every long context is new,
+ * so the time goes on finding and adding contexts rather than sampling
+ */
+void benchContexts()
+{
+    const std::size_t longOrder = 8;
+    std::mt19937 gen(4321);
+    std::uniform_int_distribution<> step(-5, 5);
+    BasicMarkovChain<std::uint32_t> chain{longOrder};
+    std::vector<std::uint32_t> memory(longOrder, 0);
+    std::uint32_t pitch = 60;
+    // the longest single update, which is what a real-time caller has to allow for
+    double worst = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto i=0; i<trainEvents * 2; ++i){
+        pitch = (std::uint32_t) std::clamp((int) pitch + step(gen), 36, 96);
+        auto one = std::chrono::steady_clock::now();
+        chain.addObservationAllOrders(memory, pitch);
+        worst = std::max(worst, millisSince(one));
+        memory.erase(memory.begin());
+        memory.push_back(pitch);
+    }
+    report("contexts", "train", trainEvents * 2, millisSince(start));
+    std::cout << "contexts slowest update " << worst << "ms" << std::endl;
+    std::cout << "contexts stored " << chain.size() << std::endl;
+    start = std::chrono::steady_clock::now();
+    long total = 0;
+    for (auto i=0; i<generateEvents; ++i){
+        std::uint32_t p = chain.generateObservation(memory, longOrder, true);
+        memory.erase(memory.begin());
+        memory.push_back(p);
+        total += chain.getOrderOfLastMatch();
+    }
+    report("contexts", "generate", generateEvents, millisSince(start));
+    std::cout << "contexts mean order " << (double) total / generateEvents << std::endl;
+}
+
+/** every engine through BasicMarkovEngine, as the manager drives them, to compare like with like */
+void benchEngines(const std::vector<std::uint8_t>& velocities)
+{
+    const std::pair<ModelEngine, std::string> engines[] = {{ModelEngine::markovChain, "engine chain"},
+        {ModelEngine::suffixAutomaton, "engine automaton"}, {ModelEngine::denseMatrix, "engine dense"}};
+    for (const auto& engine : engines){
+        std::unique_ptr<BasicMarkovEngine<std::uint8_t>> model = makeMarkovEngine<std::uint8_t>(engine.first, order);
+        std::vector<std::uint8_t> memory(order, 0);
+        auto start = std::chrono::steady_clock::now();
+        for (const std::uint8_t& v : velocities){
+            model->addObservationAllOrders(memory, v);
+            memory.erase(memory.begin());
+            memory.push_back(v);
+        }
+        report(engine.second, "train", trainEvents, millisSince(start));
+        start = std::chrono::steady_clock::now();
+        for (auto i=0; i<generateEvents; ++i){
+            std::uint8_t v = model->generateObservation(memory, order, true);
+            memory.erase(memory.begin());
+            memory.push_back(v);
+        }
+        report(engine.second, "generate", generateEvents, millisSince(start));
+    }
+}
+
+int main(){
+    std::vector<std::uint8_t> velocities = makeVelocities(trainEvents);
+    benchDynamic(velocities);
+    benchFixed(velocities);
+    benchDense(velocities);
+    benchContexts();
+    benchEngines(velocities);
+    return 0;
+}
@@ -9,23 +9,73 @@
 */
 
 #include "MarkovChain.h"
+#include "PitchSet.h"
+#include "NoteEvent.h"
+#include "RealtimeLog.h"
 #include <iostream>
 #include <ctime>
 #include <unordered_map>
+#include <algorithm>
+#include <cstdlib>
 
-MarkovChain::MarkovChain(unsigned long  _maxOrder) : maxOrder{_maxOrder}, orderOfLastMatch{0}
+template <typename State>
+BasicMarkovChain<State>::BasicMarkovChain(unsigned long  _maxOrder) : maxOrder{_maxOrder}, exactOrderLimit{0}, orderOfLastMatch{0}, 
+  lastObservation{traits::blank()}, arenaBufferSize{0}
 {
   srand((int)time(NULL));
+  sizeScratch();
+  createStorage(0);
 }
 
-MarkovChain::~MarkovChain()
+template <typename State>
+BasicMarkovChain<State>::BasicMarkovChain(const BasicMarkovChain& other) 
+: randomness{other.randomness}, maxOrder{other.maxOrder}, orders{other.orders}, 
+  exactOrderLimit{other.exactOrderLimit}, sketch{other.sketch}, orderOfLastMatch{other.orderOfLastMatch}, 
+  lastObservation{other.lastObservation}, arenaBufferSize{0}
+{
+  sizeScratch();
+  // symbols keep their ids in the copy
+  lastMatchIds.assign(other.lastMatchIds.begin(), other.lastMatchIds.end());
+  createStorage(0);
+  copyModelFrom(other);
+}
+
+template <typename State>
+BasicMarkovChain<State>& BasicMarkovChain<State>::operator=(const BasicMarkovChain& other)
+{
+  if (this == &other) return *this;
+  randomness = other.randomness;
+  maxOrder = other.maxOrder;
+  orders = other.orders;
+  exactOrderLimit = other.exactOrderLimit;
+  orderOfLastMatch = other.orderOfLastMatch;
+  sizeScratch();
+  reset();
+  copyModelFrom(other);
+  // after reset, which clears the sketch and the last match
+  sketch = other.sketch;
+  lastMatchIds.assign(other.lastMatchIds.begin(), other.lastMatchIds.end());
+  lastObservation = other.lastObservation;
+  return *this;
+}
+
+template <typename State>
+BasicMarkovChain<State>::Storage::Storage(std::pmr::memory_resource* arena)
+: eventLog{arena}, symbols{arena}, symbolIds{arena}, contexts{arena}, contextIndex{arena}
+{
+
+}
+
+template <typename State>
+BasicMarkovChain<State>::~BasicMarkovChain()
 {
 
 }
 
-void MarkovChain::addObservation(const state_sequence& prevState, state_single currentState)
+template <typename State>
+void BasicMarkovChain<State>::addObservation(const state_sequence& prevState, state_single currentState)
 {
-  if (currentState == "0")
+  if (traits::isBlank(currentState))
   {
     //std::cout << "MarkovChain::addObservation received invalid state. Ignoring it " << currentState << std::endl;
     //throw "MarkovChain::addObservation observation 0 is reserved";
@@ -36,39 +86,57 @@ void MarkovChain::addObservation(const state_sequence& prevState, state_single c
     //std::cout << "MarkovChain::addObservation invalid prev state " << std::endl;
     return; 
   }
-  state_single key = stateSequenceToString(prevState);
-  // do we have this key already
-  bool have_key = true;
-  try
+  std::vector<symbol_id>& ids = trainIds;
+  ids.clear();
+  for (const state_single& s : prevState) ids.push_back(internSymbol(s));
+  ensureLogEndsWith(ids);
+  // hash the whole context, most recent symbol first
+  std::uint64_t hash = hashOfSymbols(ids);
+  if (isApproximateOrder(ids.size()))
   {
-    model.at(key);
-  }
-  catch (const std::out_of_range& oor)
-  {
-    have_key = false;
-  }
-  // if we have this key, we are adding the new obs on that key
-  if (have_key)
-  {
-    model[key].push_back(currentState);
-  }
-  else{// new key - create a new next state sequence
-    state_sequence seq = {currentState};
-    model[key] = seq;
+    sketch.add(hash, internSymbol(currentState));
+    return;
   }
+  Context& context = findOrAddContext(hash, model->eventLog.size(), ids.size());
+  context.observations.push_back(internSymbol(currentState));
 }
 
-void MarkovChain::addObservationAllOrders(const state_sequence& prevState, state_single currentState)
+template <typename State>
+void BasicMarkovChain<State>::addObservationAllOrders(const state_sequence& prevState, state_single currentState)
 {
-  std::vector<state_sequence> allPrevs = breakStateIntoAllOrders(prevState);
-  for (state_sequence& seq : allPrevs)
+  // equivalent to calling addObservation on each of breakStateIntoAllOrders(prevState), 
+  // but every order points into the same stretch of the event log
+  // sub-sequences containing a blank "0" are invalid, so only 
+  // the part after the most recent blank is usable
+  unsigned long usable = 0;
+  while (usable < prevState.size() && !traits::isBlank(prevState[prevState.size() - 1 - usable])) usable ++;
+  // with an order set or a sketch there is no point looking past the highest order
+  if ((orders.size() > 0 || exactOrderLimit > 0) && usable > maxOrder) usable = maxOrder;
+  if (usable > 0)
   {
-    //std::cout << "MarkovChain::addObservationAllOrders adding obs for " << this->stateSequenceToString(seq) << " to " << currentState <<  std::endl; 
-    addObservation(seq, currentState);
-  } 
+    std::vector<symbol_id>& ids = trainIds;
+    ids.clear();
+    for (unsigned long i = prevState.size() - usable; i < prevState.size(); ++i) ids.push_back(internSymbol(prevState[i]));
+    ensureLogEndsWith(ids);
+    std::uint32_t logEnd = model->eventLog.size();
+    symbol_id obs = internSymbol(currentState);
+    // one pass from the most recent symbol backwards gives us the hash of every order
+    std::uint64_t hash = 0;
+    for (unsigned long order = 1; order <= usable; ++order)
+    {
+      hash = extendHash(hash, ids[usable - order]);
+      if (!usesOrder(order)) continue;
+      //std::cout << "MarkovChain::addObservationAllOrders adding obs at order " << order << " to " << currentState <<  std::endl; 
+      if (isApproximateOrder(order)) sketch.add(hash, obs);
+      else findOrAddContext(hash, logEnd, order).observations.push_back(obs);
+    }
+  }
+  // the observation is the most recent symbol of the next context
+  model->eventLog.push_back(internSymbol(currentState));
 }
 
-std::vector<state_sequence>  MarkovChain::breakStateIntoAllOrders(const state_sequence& prevState)
+template <typename State>
+std::vector<std::vector<State>> BasicMarkovChain<State>::breakStateIntoAllOrders(const state_sequence& prevState)
 {
   std::vector<state_sequence> allPrevs;
   // start is in the range 0-prevState.size() - 1
@@ -76,8 +144,8 @@ std::vector<state_sequence>  MarkovChain::breakStateIntoAllOrders(const state_se
   allPrevs.push_back(prevState);
   for (unsigned long int start = 1; start < end; ++start)
   {
-    state_sequence::const_iterator first = prevState.begin() + start;
-    state_sequence::const_iterator last = prevState.begin() + prevState.size();
+    typename state_sequence::const_iterator first = prevState.begin() + start;
+    typename state_sequence::const_iterator last = prevState.begin() + prevState.size();
     state_sequence prevStateShort(first, last);
     allPrevs.push_back(prevStateShort);
   }
@@ -85,18 +153,20 @@ std::vector<state_sequence>  MarkovChain::breakStateIntoAllOrders(const state_se
 }
 
 
-std::string MarkovChain::stateSequenceToString(const state_sequence& sequence)
+template <typename State>
+std::string BasicMarkovChain<State>::stateSequenceToString(const state_sequence& sequence)
 {
   std::string str = std::to_string(sequence.size()); // write the order first
   str.append(",");
   for (const state_single& s : sequence)
   {
-      str.append(s);
+      str.append(traits::toString(s));
       str.append(",");  
   } 
   return str;
 }
-std::string MarkovChain::stateSequenceToString(const state_sequence& sequence, long unsigned int maxOrder)
+template <typename State>
+std::string BasicMarkovChain<State>::stateSequenceToString(const state_sequence& sequence, long unsigned int maxOrder)
 {
   if (maxOrder >= sequence.size()){ 
     // max order is higher pr == than the order we have
@@ -116,106 +186,106 @@ std::string MarkovChain::stateSequenceToString(const state_sequence& sequence, l
         skipped ++;
         continue; 
      } 
-      str.append(s);
+      str.append(traits::toString(s));
       str.append(",");
     } 
     return str;
   }
 }
 
-state_single MarkovChain::generateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice)
+template <typename State>
+State BasicMarkovChain<State>::generateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice)
 {
   // check for empty model
-  if (model.size() == 0)
+  if (model->contexts.size() == 0)
   {
     //std::cout << "warning - requested obs from empty model " << std::endl;
-    return "0";
+    return traits::blank();
   }
+  state_single obs = traits::blank();
+  if (tryGenerateObservation(prevState, maxOrderWanted, needChoice, obs)) return obs;
+  // worst case - nothing at higher than zero order
+  this->orderOfLastMatch = 0;
+  //std::cout << "MarkovChain::generateObservation no match doing zero order " << std::endl;
+  obs = zeroOrderSample();
+  lastMatchIds.clear();
+  lastObservation = obs;
+  return obs; 
+}
+
+template <typename State>
+bool BasicMarkovChain<State>::tryGenerateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice, state_single& obs)
+{
+  if (model->contexts.size() == 0) return false;
   // don't allow orders beyond our own maxOrder
-  if (maxOrderWanted > this->maxOrder) maxOrderWanted = this->maxOrder;
-  // attempt to find a key in the chain that matches the incoming prevState
-  state_single key = stateSequenceToString(prevState, maxOrderWanted);
-  state_sequence poss_next_states{};
-  bool have_key = true;
-  // bad boy using exception handling for control flow. live on the edge! 
-  try
+  if (maxOrderWanted > (int) this->maxOrder) maxOrderWanted = this->maxOrder;
+  if (maxOrderWanted > (int) prevState.size()) maxOrderWanted = prevState.size();
+  // convert the most recent part of prevState to symbol ids. 
+  // stop at blanks or symbols we have never seen - no context can contain those
+  symbol_id* ids = lookupIds.data();
+  int usable = 0;
+  while (usable < maxOrderWanted)
   {
-    poss_next_states = model.at(key);
-    //std::cout << "MarkovChain::generateObservation want choice " << needChoice << "  got choices" << poss_next_states.size() << std::endl;
-    
-    // now if the caller demanded choices, we need to check there are choices
-    if (needChoice && poss_next_states.size() < 2) { // want choice, none there
-      //std::cout << "MarkovChain::generateObservation want choice but only " << poss_next_states.size() << " going lower order than " << maxOrderWanted << std::endl;
-      have_key = false; 
-    }
-
+    const state_single& s = prevState[prevState.size() - 1 - usable];
+    if (traits::isBlank(s) || !findSymbol(s, ids[maxOrderWanted - 1 - usable])) break;
+    usable ++;
   }
-  catch (const std::out_of_range& oor)
+  // hash every order in one pass, then try them from the highest down
+  std::uint64_t* hashes = lookupHashes.data();
+  hashes[0] = 0;
+  for (int order = 1; order <= usable; ++order)
   {
-    have_key = false;
+    hashes[order] = extendHash(hashes[order - 1], ids[maxOrderWanted - order]);
   }
-  if (have_key)
+  for (int order = usable; order > 0; --order)
   {
-    // get a random choice from the available ones 
-    //std::cout << "MarkovChain::generateObservation key: '" << key << "' Got possible next states " << poss_next_states.size() << std::endl;
-    state_single obs = pickRandomObservation(poss_next_states);
-    // remember what we did
-    this->orderOfLastMatch = maxOrderWanted; 
-    this->lastMatch = state_and_observation{key, obs};
-    return obs; 
-  }
-  else {
-    //std::cout << "MarkovChain::generateObservation no match for that key " << key << "  at order " << maxOrderWanted << std::endl;
-    if (maxOrderWanted > 1) 
+    if (!usesOrder(order)) continue;
+    symbol_id sketched;
+    if (isApproximateOrder(order))
     {
-      //std::cout << "no match, reducing order to " << maxOrder - 1 << std::endl;
-      // recurse with lower max order
-      return generateObservation(prevState, maxOrderWanted-1, needChoice);
+      if (!pickSketchObservation(hashes[order], needChoice, sketched)) continue;
+      obs = state_single{model->symbols[sketched]};
+      this->orderOfLastMatch = order;
+      lastMatchIds.assign(ids + maxOrderWanted - order, ids + maxOrderWanted);
+      lastObservation = obs;
+      return true;
     }
-    else {
-      // worst case - nothing at higher than zero order
-      this->orderOfLastMatch = 0;
-      //std::cout << "MarkovChain::generateObservation no match for " << key << " doing zero order " << std::endl;
-      state_single obs = zeroOrderSample();
-      this->lastMatch = state_and_observation{"0", obs};
-      return obs; 
+    Context* context = findContext(hashes[order], ids + maxOrderWanted - order, order);
+    // now if the caller demanded choices, we need to check there are choices
+    if (context == nullptr || (needChoice && context->observations.size() < 2)) 
+    {
+      //std::cout << "MarkovChain::generateObservation no match at order " << order << std::endl;
+      continue;
     }
+    // get a random choice from the available ones 
+    obs = pickRandomObservation(*context);
+    // remember what we did
+    this->orderOfLastMatch = order; 
+    lastMatchIds.assign(ids + maxOrderWanted - order, ids + maxOrderWanted);
+    lastObservation = obs;
+    return true; 
   }
+  return false;
 }
 
-state_single MarkovChain::zeroOrderSample()
+template <typename State>
+State BasicMarkovChain<State>::zeroOrderSample()
 {
-
-  state_sequence poss_next_states{};
   // no key - choose something at random from all next observed states
-  int randInd = 0;
-  if (model.size() > 1) randInd = rand() % model.size();
-  //std::cout << "MarkovChain::zeroOrderSample rand " << randInd << " from " << model.size() << std::endl; 
-  int ind = 0;
-  state_single state = "0"; // start on the default state
-  // iterate the map until we teach our random index
-  // have to do this as skips are not possible
-  for (std::map<std::string,state_sequence>::iterator it=model.begin();it!=model.end(); ++it)
-  {
-    if (ind == randInd){
-      poss_next_states = (it->second);
-      state = pickRandomObservation(poss_next_states);
-      break;// jump down to the return statement 
-    }
-    else {
-      ind ++;
-      continue;
-    }
-  }
+  std::size_t randInd = 0;
+  if (model->contexts.size() > 1) randInd = rand() % model->contexts.size();
+  //std::cout << "MarkovChain::zeroOrderSample rand " << randInd << " from " << model->contexts.size() << std::endl; 
+  state_single state = traits::blank(); // start on the default state
+  if (randInd < model->contexts.size()) state = pickRandomObservation(model->contexts[randInd]);
   return state;
 }
 
-
-state_single MarkovChain::pickRandomObservation(const state_sequence& seq)
+template <typename State>
+State BasicMarkovChain<State>::pickRandomObservation(const state_sequence& seq)
 {
   if (seq.size() == 0) // they key existed but there';s nothing there.
   {
-    return "0";
+    return traits::blank();
   } 
   auto ind = 0;
   if (seq.size() > 1) ind = rand() % seq.size();  
@@ -223,28 +293,64 @@ state_single MarkovChain::pickRandomObservation(const state_sequence& seq)
   //return "0";
 }
 
-std::string MarkovChain::toString()
+template <typename State>
+State BasicMarkovChain<State>::pickRandomObservation(const Context& context)
+{
+  if (context.observations.size() == 0) // they key existed but there';s nothing there.
+  {
+    return traits::blank();
+  } 
+  auto ind = 0;
+  if (context.observations.size() > 1) ind = rand() % context.observations.size();  
+  return state_single{model->symbols[context.observations[ind]]};
+}
+
+template <typename State>
+std::string BasicMarkovChain<State>::toString()
 {
-  //std::cout << "MarkovChain::toString model size " << model.size() << std::endl;
+  //std::cout << "MarkovChain::toString model size " << model->contexts.size() << std::endl;
+  // sort on the keys so the output is the same as it was with 
+  // the string keyed map, whatever order the hash table is in
+  std::vector<std::pair<std::string, const Context*>> keys{};
+  keys.reserve(model->contexts.size());
+  for (const Context& context : model->contexts) keys.push_back({contextToString(context), &context});
+  std::sort(keys.begin(), keys.end(), 
+    [](const std::pair<std::string, const Context*>& a, const std::pair<std::string, const Context*>& b){ return a.first < b.first; });
   std::string s{""};
-  for(auto const& kv_pair: model){
-    s += kv_pair.first + ":";
-    s += this->stateSequenceToString(model[kv_pair.first]);
+  // only written for order sets, so full order models save exactly as before.
+  // older versions skip this line as its key has no order number
+  if (orders.size() > 0)
+  {
+    s += "orders:" + std::to_string(orders.size()) + ",";
+    for (const unsigned long& order : orders) s += std::to_string(order) + ",";
+    s += "\n";
+  }
+  for(auto const& key: keys){
+    s += key.first + ":";
+    // same layout as stateSequenceToString: count first, then the observations
+    s += std::to_string(key.second->observations.size());
+    s += ",";
+    for (const symbol_id& obs : key.second->observations)
+    {
+      s += traits::toString(state_single{model->symbols[obs]});
+      s += ",";
+    }
     s += "\n";
   }
   return s;
 }
 
-bool MarkovChain::validateStateToObservationsString(const std::string& data)
+template <typename State>
+bool BasicMarkovChain<State>::validateStateToObservationsString(const std::string& data)
 {
 //    * super basic: minimal string is '1,a:2,b'-> length >= 7  
   if (data.size() < 7) {
-    std::cout << "MarkovChain::validateDataString too short " << std::endl;  
+    MARKOV_LOG(warning, "MarkovChain::validateDataString too short", 0);
     return false; 
   }
 //  * does it have a colon?
   if (data.find_first_of(':') == std::string::npos) {
-    std::cout << "MarkovChain::validateDataString no colon " << std::endl;  
+    MARKOV_LOG(warning, "MarkovChain::validateDataString no colon", 0);
     return false; 
   }
 //  * does it have at least two commas? 
@@ -257,13 +363,14 @@ bool MarkovChain::validateStateToObservationsString(const std::string& data)
     found=data.find_first_of(',',found+1);
   }
   if (count < 2){
-    std::cout << "MarkovChain::validateDataString need two commas" << std::endl;  
+    MARKOV_LOG(warning, "MarkovChain::validateDataString need two commas", 0);
     return false; 
   }
   return true;
 
 }
-bool MarkovChain::fromString(const std::string& savedModel)
+template <typename State>
+bool BasicMarkovChain<State>::fromString(const std::string& savedModel)
 {
   //unsigned long int startSize = model.size();
   // example
@@ -280,17 +387,27 @@ bool MarkovChain::fromString(const std::string& savedModel)
   // split [1] on ','
   // convert first element to int (it is the number of different observations)
   // convert the remaining elements to a string vector
-  std::vector<std::string> lines = MarkovChain::tokenise(savedModel, '\n');
+  std::vector<std::string> lines = tokenise(savedModel, '\n');
   for (const std::string& line : lines){
     //std::cout << "MarkovChain::fromString processing line " << line << std::endl; 
 
+    if (line.rfind("orders:", 0) == 0)
+    {
+      std::vector<unsigned long> savedOrders{};
+      std::vector<std::string> parts = tokenise(line.substr(7), ',');
+      for (unsigned long i=1;i<parts.size();++i){ // 1 as first is the count
+        savedOrders.push_back(std::strtoul(parts[i].c_str(), nullptr, 10));
+      }
+      setOrders(savedOrders);
+      continue;
+    }
     // skip invalid lines
-    if (! MarkovChain::validateStateToObservationsString(line)) continue; 
+    if (! validateStateToObservationsString(line)) continue; 
     //std::cout << "MarkovChain::fromString line valid. tokenising on ':'" << line << std::endl; 
     std::string newline = line + ":";
-    std::vector<std::string> k_v = MarkovChain::tokenise(newline, ':');
+    std::vector<std::string> k_v = tokenise(newline, ':');
     //std::cout << "MarkovChain::fromString tokenised line to " << k_v[0] << " and " << k_v[1] << " getting prev state "<< std::endl; 
-    state_sequence prevState = MarkovChain::tokenise(k_v[0], ',');
+    std::vector<std::string> prevState = tokenise(k_v[0], ',');
     // maybe remove unwanted elements from prevState here...
     // ... here... 
     state_sequence prevStateFilt{};
@@ -299,12 +416,12 @@ bool MarkovChain::fromString(const std::string& savedModel)
     //std::cout << "MarkovChain::fromString building prev state. size is " << prevState.size() << std::endl; 
 
     for (unsigned long i=1;i<prevState.size();++i){
-      prevStateFilt.push_back(prevState[i]);
+      prevStateFilt.push_back(traits::fromString(prevState[i]));
     }
-    state_sequence all_obs = MarkovChain::tokenise(k_v[1], ','); // all observations following that state
+    std::vector<std::string> all_obs = tokenise(k_v[1], ','); // all observations following that state
     if (all_obs.size() == 1) continue; // should have a number then the actual states so len at least 2
     for (unsigned long i=1;i<all_obs.size();++i){ // 1 as first is no. different observations
-      this->addObservation(prevStateFilt, all_obs[i]);
+      this->addObservation(prevStateFilt, traits::fromString(all_obs[i]));
     }
   }
   // at this point, we hope something was loaded. if the file was invalid, meh
@@ -313,88 +430,356 @@ bool MarkovChain::fromString(const std::string& savedModel)
   //else return false; 
 }
 
-void MarkovChain::reset()
+template <typename State>
+void BasicMarkovChain<State>::setOrders(std::vector<unsigned long> _orders)
 {
-    model.clear();
+  std::sort(_orders.begin(), _orders.end());
+  _orders.erase(std::unique(_orders.begin(), _orders.end()), _orders.end());
+  // zero order does not need storing
+  if (_orders.size() > 0 && _orders[0] == 0) _orders.erase(_orders.begin());
+  orders = _orders;
+  if (orders.size() > 0) maxOrder = orders.back();
+  sizeScratch();
 }
 
-int MarkovChain::getOrderOfLastMatch()
+template <typename State>
+std::vector<unsigned long> BasicMarkovChain<State>::getOrders()
 {
-  return this->orderOfLastMatch;
+  return orders;
 }
 
-state_and_observation MarkovChain::getLastMatch()
+template <typename State>
+void BasicMarkovChain<State>::setExactOrderLimit(unsigned long order, std::size_t sketchWidth)
 {
-  return this->lastMatch;
+  exactOrderLimit = order;
+  if (order == 0) sketch.resize(0);
+  else sketch.resize(sketchWidth);
 }
 
-void  MarkovChain::removeMapping(state_single state_key, state_single unwanted_option)
+template <typename State>
+unsigned long BasicMarkovChain<State>::getExactOrderLimit()
 {
-  if (model.size() ==0 ) return; 
-  state_sequence current_options{};
-  bool have_key = true;
-  try
-  {
-    current_options = model.at(state_key);
-  }
-  catch (const std::out_of_range& oor)
+  return exactOrderLimit;
+}
+
+template <typename State>
+bool BasicMarkovChain<State>::isApproximateOrder(unsigned long order)
+{
+  return exactOrderLimit > 0 && order > exactOrderLimit;
+}
+
+template <typename State>
+bool BasicMarkovChain<State>::pickSketchObservation(std::uint64_t hash, bool needChoice, symbol_id& obs)
+{
+  symbol_id candidates[ContextSketch::candidatesPerContext];
+  std::uint32_t weights[ContextSketch::candidatesPerContext];
+  std::size_t count = sketch.getCandidates(hash, candidates);
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < count; ++i)
   {
-    have_key = false; // nothing to do as we don't even have the state_key 
+    weights[i] = sketch.estimate(hash, candidates[i]);
+    total += weights[i];
   }
-  if (have_key) // we have seen this state_key
+  // same rule as the exact contexts: needChoice wants at least two observations
+  if (total == 0 || (needChoice && total < 2)) return false;
+  std::uint64_t choice = rand() % total;
+  for (std::size_t i = 0; i < count; ++i)
   {
-    // create a new set of possible 
-    state_sequence updated_options{};
-    for (const state_single& obs : current_options)
+    if (choice < weights[i])
     {
-      if (obs != unwanted_option)
-      {
-        updated_options.push_back(obs);
-      }
+      obs = candidates[i];
+      return true;
     }
-    this->model[state_key] = updated_options;
+    choice -= weights[i];
+  }
+  return false;
+}
+
+template <typename State>
+bool BasicMarkovChain<State>::usesOrder(unsigned long order)
+{
+  if (orders.size() == 0) return true;
+  return std::binary_search(orders.begin(), orders.end(), order);
+}
+
+template <typename State>
+void BasicMarkovChain<State>::reset()
+{
+  // drop the model first, then give all of its memory back 
+  // to the arena in one go. Any preallocated buffer is kept for re-use.
+  model.reset();
+  arena->release();
+  model = std::make_unique<Storage>(arena.get());
+  // the sketch and the last match refer to symbol ids, which have just gone
+  sketch.clear();
+  lastMatchIds.clear();
+}
+
+template <typename State>
+void BasicMarkovChain<State>::sizeScratch()
+{
+  lookupIds.resize(maxOrder);
+  lookupHashes.resize(maxOrder + 1);
+  lastMatchIds.reserve(maxOrder);
+  trainIds.reserve(maxOrder);
+}
+
+template <typename State>
+void BasicMarkovChain<State>::reserveMemory(std::size_t bytes)
+{
+  if (bytes <= arenaBufferSize) return; 
+  // build the new arena, then copy the current model over 
+  BasicMarkovChain old{*this};
+  model.reset();
+  createStorage(bytes);
+  copyModelFrom(old);
+}
+
+template <typename State>
+std::size_t BasicMarkovChain<State>::getReservedMemory()
+{
+  return arenaBufferSize;
+}
+
+template <typename State>
+void BasicMarkovChain<State>::createStorage(std::size_t bytes)
+{
+  arenaBufferSize = bytes;
+  if (bytes > 0)
+  {
+    arenaBuffer = std::make_unique<std::byte[]>(bytes);
+    arena = std::make_unique<std::pmr::monotonic_buffer_resource>(
+                    arenaBuffer.get(), bytes, std::pmr::new_delete_resource());
+  }
+  else 
+  {
+    arenaBuffer.reset();
+    arena = std::make_unique<std::pmr::monotonic_buffer_resource>(std::pmr::new_delete_resource());
+  }
+  model = std::make_unique<Storage>(arena.get());
+}
+
+template <typename State>
+void BasicMarkovChain<State>::copyModelFrom(const BasicMarkovChain& other)
+{
+  // pmr containers do not carry their allocator across a copy,
+  // so copy everything into our own arena
+  model->eventLog.assign(other.model->eventLog.begin(), other.model->eventLog.end());
+  for (const typename traits::stored_type& symbol : other.model->symbols) internSymbol(symbol);
+  for (const Context& context : other.model->contexts)
+  {
+    // the hash is not kept, but the log it is made from was copied over
+    std::uint64_t hash = 0;
+    for (std::uint32_t i = context.end; i > context.end - context.length; --i) hash = extendHash(hash, model->eventLog[i - 1]);
+    model->contextIndex.insert(hash, model->contexts.size());
+    model->contexts.push_back(Context{context.end, context.length, 
+              std::pmr::vector<symbol_id>{context.observations.begin(), context.observations.end(), arena.get()}});
+  }
+}
+
+template <typename State>
+typename BasicMarkovChain<State>::symbol_id BasicMarkovChain<State>::internSymbol(typename traits::lookup_type symbol)
+{
+  symbol_id id;
+  if (findSymbol(symbol, id)) return id;
+  id = model->symbols.size();
+  model->symbols.emplace_back(symbol);
+  model->symbolIds[model->symbols.back()] = id;
+  return id;
+}
+
+template <typename State>
+bool BasicMarkovChain<State>::findSymbol(typename traits::lookup_type symbol, symbol_id& id)
+{
+  auto it = model->symbolIds.find(symbol);
+  if (it == model->symbolIds.end()) return false;
+  id = it->second;
+  return true;
+}
+
+template <typename State>
+void BasicMarkovChain<State>::ensureLogEndsWith(const std::vector<symbol_id>& ids)
+{
+  std::pmr::vector<symbol_id>& log = model->eventLog;
+  // when we are fed by the manager, the log already ends with the context
+  if (log.size() >= ids.size() && 
+      std::equal(ids.begin(), ids.end(), log.end() - ids.size())) return; 
+  log.insert(log.end(), ids.begin(), ids.end());
+}
+
+template <typename State>
+std::uint64_t BasicMarkovChain<State>::extendHash(std::uint64_t hash, symbol_id symbol)
+{
+  hash = (hash + symbol + 1) * 0x9E3779B97F4A7C15ull;
+  return hash ^ (hash >> 29);
+}
+
+template <typename State>
+std::uint64_t BasicMarkovChain<State>::hashOfSymbols(const std::vector<symbol_id>& ids)
+{
+  std::uint64_t hash = 0;
+  for (unsigned long i = ids.size(); i > 0; --i) hash = extendHash(hash, ids[i - 1]);
+  return hash;
+}
+
+template <typename State>
+typename BasicMarkovChain<State>::Context* BasicMarkovChain<State>::findContext(std::uint64_t hash, const symbol_id* ids, std::uint32_t length)
+{
+  // different contexts can share a hash, so check the symbols too
+  std::uint32_t found = model->contextIndex.find(hash, [&](std::uint32_t number){
+    const Context& context = model->contexts[number];
+    return context.length == length && 
+      std::equal(ids, ids + length, model->eventLog.begin() + (context.end - length));
+  });
+  if (found == ContextTable::notFound) return nullptr;
+  return &model->contexts[found];
+}
+
+template <typename State>
+typename BasicMarkovChain<State>::Context& BasicMarkovChain<State>::findOrAddContext(std::uint64_t hash, std::uint32_t logEnd, std::uint32_t length)
+{
+  Context* found = findContext(hash, model->eventLog.data() + (logEnd - length), length);
+  if (found != nullptr) return *found;
+  model->contextIndex.insert(hash, model->contexts.size());
+  model->contexts.push_back(Context{logEnd, length, std::pmr::vector<symbol_id>{arena.get()}});
+  return model->contexts.back();
+}
+
+template <typename State>
+bool BasicMarkovChain<State>::keyToSymbols(const std::string& key, std::vector<symbol_id>& ids)
+{
+  // e.g. "2,a,b," -> [a, b]
+  std::vector<std::string> parts = tokenise(key, ',');
+  if (parts.size() < 2) return false; 
+  if (std::strtoul(parts[0].c_str(), nullptr, 10) != parts.size() - 1) return false; 
+  ids.clear();
+  for (unsigned long i=1;i<parts.size();++i)
+  {
+    symbol_id id;
+    if (!findSymbol(traits::fromString(parts[i]), id)) return false; 
+    ids.push_back(id);
+  }
+  return true;
+}
+
+template <typename State>
+typename BasicMarkovChain<State>::Context* BasicMarkovChain<State>::findContextForKey(const std::string& key)
+{
+  std::vector<symbol_id> ids{};
+  if (!keyToSymbols(key, ids)) return nullptr;
+  return findContext(hashOfSymbols(ids), ids.data(), ids.size());
+}
+
+template <typename State>
+std::string BasicMarkovChain<State>::contextToString(const Context& context)
+{
+  std::string str = std::to_string(context.length); // write the order first
+  str.append(",");
+  for (std::uint32_t i = context.end - context.length; i < context.end; ++i)
+  {
+    str.append(traits::toString(state_single{model->symbols[model->eventLog[i]]}));
+    str.append(",");
+  }
+  return str;
+}
+
+template <typename State>
+int BasicMarkovChain<State>::getOrderOfLastMatch()
+{
+  return this->orderOfLastMatch;
+}
+
+template <typename State>
+std::pair<std::string, State> BasicMarkovChain<State>::getLastMatch()
+{
+  if (lastMatchIds.empty()) return state_and_observation{"0", lastObservation};
+  // the same layout as contextToString
+  std::string key = std::to_string(lastMatchIds.size()) + ",";
+  for (const symbol_id& id : lastMatchIds) key += traits::toString(state_single{model->symbols[id]}) + ",";
+  return state_and_observation{key, lastObservation};
+}
+
+template <typename State>
+void BasicMarkovChain<State>::removeMapping(std::string state_key, State unwanted_option)
+{
+  if (model->contexts.size() ==0 ) return; 
+  std::vector<symbol_id> ids{};
+  symbol_id unwanted;
+  if (keyToSymbols(state_key, ids) && isApproximateOrder(ids.size()))
+  {
+    if (findSymbol(unwanted_option, unwanted)) sketch.removeCandidate(hashOfSymbols(ids), unwanted);
+    return;
   }
+  Context* context = findContextForKey(state_key);
+  if (context != nullptr && findSymbol(unwanted_option, unwanted)) // we have seen this state_key
+  {
+    // filter the options in place, keeping their arena storage
+    std::pmr::vector<symbol_id>& options = context->observations;
+    options.erase(std::remove(options.begin(), options.end(), unwanted), options.end());
+  }
+  // else nothing to do as we don't even have the state_key 
 }
 
-void MarkovChain::amplifyMapping(state_single state_key, state_single wanted_option)
+template <typename State>
+void BasicMarkovChain<State>::amplifyMapping(std::string state_key, State wanted_option)
 {
-  if (model.size() ==0 ) return; 
-  state_sequence options = getOptionsForSequenceKey(state_key);
-  if (options.size() == 0) // nothing mapped to this key... easy! 
+  if (model->contexts.size() ==0 ) return; 
+  std::vector<symbol_id> ids{};
+  if (keyToSymbols(state_key, ids) && isApproximateOrder(ids.size()))
   {
-    options.push_back(wanted_option);
-    this->model[state_key] = options; 
+    // match the estimated count of the others
+    std::uint64_t hash = hashOfSymbols(ids);
+    symbol_id wanted = internSymbol(wanted_option);
+    symbol_id candidates[ContextSketch::candidatesPerContext];
+    std::size_t count = sketch.getCandidates(hash, candidates);
+    std::uint32_t othermappings = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      if (candidates[i] != wanted) othermappings += sketch.estimate(hash, candidates[i]);
+    }
+    sketch.add(hash, wanted, othermappings > 0 ? othermappings : 1);
+    return;
+  }
+  Context* context = findContextForKey(state_key);
+  if (context == nullptr) // nothing mapped to this key... easy! 
+  {
+    std::vector<std::string> parts = tokenise(state_key, ',');
+    if (parts.size() < 2) return; 
+    state_sequence prevState{};
+    for (unsigned long i=1;i<parts.size();++i) prevState.push_back(traits::fromString(parts[i]));
+    addObservation(prevState, wanted_option);
     return; 
   }
+  symbol_id wanted_id = internSymbol(wanted_option);
   // how many of the wanted option are there, relative to the total?
   float wanted = 0;
   float othermappings = 0;
-  for (const state_single& s : options) {
-    if (s == wanted_option) wanted ++;
+  for (const symbol_id& s : context->observations) {
+    if (s == wanted_id) wanted ++;
     else othermappings ++;
   }
   // basically match the number of othermappings
   // to make this mapping as likely as any other
-  for (auto i=0;i<othermappings;i++) model[state_key].push_back(wanted_option);
+  for (auto i=0;i<othermappings;i++) context->observations.push_back(wanted_id);
 }
 
 
-state_sequence MarkovChain::getOptionsForSequenceKey(state_single seqAsKey)
+template <typename State>
+std::vector<State> BasicMarkovChain<State>::getOptionsForSequenceKey(std::string seqAsKey)
 {
   state_sequence options{};
-  try
-  {
-    options = model.at(seqAsKey);
-  }
-  catch (const std::out_of_range& oor)
+  Context* context = findContextForKey(seqAsKey);
+  if (context != nullptr)
   {
-    // that's ok...we caught it :) 
+    // copy out of the arena
+    for (const symbol_id& s : context->observations) options.emplace_back(model->symbols[s]);
   }
   return options; 
 }
 
 
-std::vector<std::string> MarkovChain::tokenise(const std::string& input, char separator)
+template <typename State>
+std::vector<std::string> BasicMarkovChain<State>::tokenise(const std::string& input, char separator)
 {
    std::vector<std::string> tokens;
    long unsigned int start, end;
@@ -415,24 +800,34 @@ std::vector<std::string> MarkovChain::tokenise(const std::string& input, char se
    return tokens; 
 }
 
-long MarkovChain::size()
+template <typename State>
+long BasicMarkovChain<State>::size()
 {
-  return model.size();
+  return model->contexts.size();
 }
 
-bool MarkovChain::validateStateSequence(const state_sequence& seq)
+template <typename State>
+bool BasicMarkovChain<State>::validateStateSequence(const state_sequence& seq)
 {
   if (seq.size() == 0) return false; 
   for (const state_single& s : seq)
   {
-    if (s == "0") // blank state - this state sequence is not useable 
+    if (traits::isBlank(s)) // blank state - this state sequence is not useable 
       return false;
   } 
   return true;
   
 }
 
-float MarkovChain::getRandomness(){
+template <typename State>
+float BasicMarkovChain<State>::getRandomness(){
   return this->randomness;
 }
 
+
+// the state types the chain is built for. Add new state types here
+template class BasicMarkovChain<std::string>;
+template class BasicMarkovChain<std::uint8_t>;
+template class BasicMarkovChain<std::uint32_t>;
+template class BasicMarkovChain<PitchSet>;
+template class BasicMarkovChain<NoteEvent>;
@@ -9,9 +9,18 @@
   ==============================================================================
 */
 #include <string>
+#include <string_view>
 #include <map>
+#include <deque>
+#include <unordered_map>
 #include <vector>
+#include <cstdint>
 #include <random>
+#include <memory>
+#include <memory_resource>
+#include "ContextSketch.h"
+#include "ContextTable.h"
+#include "StateTraits.h"
 
 #pragma once
 
@@ -20,12 +29,30 @@ typedef std::string state_single;
 typedef std::pair<state_single, state_single> state_and_observation;
 
 /**
- * Represents a markov chain
+ * Represents a markov chain over states of type State, which needs
+ * a StateTraits so the chain knows how to store, hash and save it.
+ * MarkovChain is the original chain of strings.
  */
-class MarkovChain {
+template <typename State>
+class BasicMarkovChain {
   public:
-    MarkovChain(unsigned long _maxOrder=65);
-    ~MarkovChain();
+    /** within the chain, states and sequences are of the chain's own type */
+    typedef State state_single;
+    typedef std::vector<State> state_sequence;
+    /** the key of a context (see stateSequenceToString) and the state that followed it */
+    typedef std::pair<std::string, State> state_and_observation;
+    typedef StateTraits<State> traits;
+
+    /** what memoryFor allows for each new context and symbol, and once for the model. measured, with some room */
+    static constexpr std::size_t bytesPerContext = 160;
+    static constexpr std::size_t bytesPerSymbol = 192 + 4 * sizeof(typename traits::stored_type);
+    static constexpr std::size_t reserveOverhead = 64 * 1024;
+
+    BasicMarkovChain(unsigned long _maxOrder=65);
+    /** copies the model into a fresh arena owned by the new chain */
+    BasicMarkovChain(const BasicMarkovChain& other);
+    BasicMarkovChain& operator=(const BasicMarkovChain& other);
+    ~BasicMarkovChain();
     /** 
      * addObservation
      * add a single observation to the chain
@@ -43,6 +70,27 @@ class MarkovChain {
      * @param currentState - the state observed
      */
     void addObservationAllOrders(const state_sequence& prevState, state_single currentState);
+    /**
+     * setOrders: only store and match contexts of the sent orders, e.g. {1, 2, 4, 8}
+     * instead of every order from 1 to maxOrder. maxOrder becomes the highest order sent.
+     * Zero order is always available. An empty list goes back to using all orders.
+     * Existing contexts of other orders are kept, but no longer used.
+     */
+    void setOrders(std::vector<unsigned long> orders);
+    /** the orders set with setOrders - empty if all orders are in use */
+    std::vector<unsigned long> getOrders();
+    /**
+     * setExactOrderLimit: hybrid mode. Contexts up to 'order' long are stored exactly, 
+     * longer ones go into a ContextSketch of fixed size, with sketchWidth counters per row. 
+     * Long contexts are mostly seen once, so this stops them from growing the model 
+     * for as long as the session runs, at the cost of occasionally recalling the 
+     * wrong continuation. 0 turns hybrid mode off. Call it before training: 
+     * existing long contexts are not moved into the sketch.
+     * The sketch is not written by toString.
+     */
+    void setExactOrderLimit(unsigned long order, std::size_t sketchWidth=65536);
+    /** the order set with setExactOrderLimit, 0 if every order is exact */
+    unsigned long getExactOrderLimit();
 
   // should be private once testing is complete... 
   // note to self - how to enable testing of private methods? 
@@ -92,6 +140,11 @@ class MarkovChain {
      * @return a state sampled from the model
      */
     state_single generateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice=false);
+    /**
+     * as generateObservation, but without the zero order fallback. 
+     * @return false, leaving obs alone, if no order above zero matched
+     */
+    bool tryGenerateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice, state_single& obs);
   /**
    * Picks a random observation from the sent sequence. 
    */
@@ -115,8 +168,34 @@ class MarkovChain {
     bool fromString(const std::string& savedModel);
 
     /** Yank the chain, as it were. 
+     * All keys and observations live in the chain's arena, so this 
+     * hands the whole lot back in one go rather than freeing them one by one.
      */
     void reset();
+    /**
+     * reserveMemory: preallocate the arena used for the model storage so that 
+     * training does not go to the system allocator until 'bytes' have been used up. 
+     * Existing observations are carried over into the new arena. 
+     * The arena only takes memory back on reset, so size the reserve with memoryFor. 
+     * Call from a non real-time thread, e.g. prepareToPlay. 
+     * Calling it again with the same or a smaller size does nothing. 
+     */
+    void reserveMemory(std::size_t bytes);
+    /**
+     * memoryFor: bytes to reserve so that training 'events' observations at 'exactOrders'
+     * exact orders stays within the reserve. Orders above the exact order limit go into the
+     * sketch and cost nothing here. It is a bound for the worst case, where every context
+     * and every symbol is new, and it allows for the memory the arena never gets back:
+     * the storage vectors leave behind when they grow, the old context index while it
+     * migrates and the observations feedback removes. Music repeats itself, so a model
+     * usually needs a fraction of it.
+     */
+    static constexpr std::size_t memoryFor(std::size_t events, unsigned long exactOrders)
+    {
+      return reserveOverhead + events * (exactOrders * bytesPerContext + bytesPerSymbol);
+    }
+    /** returns the number of bytes preallocated by reserveMemory */
+    std::size_t getReservedMemory();
     /**return the order of the last match generated from generateObservation
      */
     int getOrderOfLastMatch();
@@ -135,17 +214,17 @@ class MarkovChain {
    * remove the mapping from the sent state key (derived from a state_sequence via stateSequenceToString) to the sent observation 
    * where state_key should be a key in this->map
    */
-    void removeMapping(state_single state_key, state_single unwanted_option);
+    void removeMapping(std::string state_key, state_single unwanted_option);
     
   /**
    * increase the chance of the sent mapping occuring by a certain amount 
    */
-    void amplifyMapping(state_single state_key, state_single unwanted_option);
+    void amplifyMapping(std::string state_key, state_single unwanted_option);
     
     /** return number of observations in the chain*/
     long size();
 
-    /** checks if the sent state sequence is valid. i.e. does it contain blanks : "0" */
+    /** checks if the sent state sequence is valid. i.e. does it contain blanks : "0" for strings */
     bool validateStateSequence(const state_sequence& seq);
 
   /**
@@ -157,13 +236,81 @@ class MarkovChain {
 
     float randomness = 0.0f;
 
-    float MarkovChain::getRandomness();
+    float getRandomness();
 private:
+/** symbols are interned, contexts and observations refer to them by id */
+    typedef std::uint32_t symbol_id;
+/**
+ * A context is not stored as a copy of its symbols: it is the 'length' symbols 
+ * of the event log that finish just before 'end'
+ */
+    struct Context {
+      std::uint32_t end;
+      std::uint32_t length;
+      std::pmr::vector<symbol_id> observations;
+    };
+/** the model storage: everything in here is allocated from the chain's arena */
+    struct Storage {
+      Storage(std::pmr::memory_resource* arena);
+      /** append-only log of the symbols that contexts point into */
+      std::pmr::vector<symbol_id> eventLog;
+      /** deque so the symbols never move and the views in symbolIds stay valid */
+      std::pmr::deque<typename traits::stored_type> symbols;
+      std::pmr::unordered_map<typename traits::lookup_type, symbol_id, typename traits::hash> symbolIds;
+      /** deque so contexts never move when more are added */
+      std::pmr::deque<Context> contexts;
+      /** finds a context's position in contexts from the hash of its symbols */
+      ContextTable contextIndex;
+    };
+/**
+ * (re)creates the arena and an empty model on top of it. 
+ * if bytes > 0, the arena starts with a preallocated buffer of that size 
+ */
+    void createStorage(std::size_t bytes);
+/** copies the model of the sent chain into our own storage */
+    void copyModelFrom(const BasicMarkovChain& other);
+/** returns the id of the sent symbol, adding it to the symbol table if needed */
+    symbol_id internSymbol(typename traits::lookup_type symbol);
+/** looks up the id of the sent symbol. returns false if we have never seen it */
+    bool findSymbol(typename traits::lookup_type symbol, symbol_id& id);
+/** 
+ * makes sure the sent symbols are the most recent entries in the event log, 
+ * appending them if they are not, so a context can point at them
+ */
+    void ensureLogEndsWith(const std::vector<symbol_id>& ids);
+/** 
+ * hash of a context one symbol longer than the one that produced 'hash'.
+ * contexts are hashed from the most recent symbol backwards, so 
+ * all the orders of one context come out of a single pass
+ */
+    static std::uint64_t extendHash(std::uint64_t hash, symbol_id symbol);
+/** hash of a whole context, as built up by extendHash */
+    static std::uint64_t hashOfSymbols(const std::vector<symbol_id>& ids);
+/** 
+ * finds the context made of the last 'length' entries of 'ids', 
+ * comparing against the event log in place. returns nullptr if there is none
+ */
+    Context* findContext(std::uint64_t hash, const symbol_id* ids, std::uint32_t length);
+/** 
+ * as findContext, but adds a context pointing at the log ending at logEnd if it is not there 
+ */
+    Context& findOrAddContext(std::uint64_t hash, std::uint32_t logEnd, std::uint32_t length);
+/** 
+ * converts a key from stateSequenceToString back into symbol ids.
+ * returns false if it is malformed or uses symbols we have never seen 
+ */
+    bool keyToSymbols(const std::string& key, std::vector<symbol_id>& ids);
+/** finds the context for a key from stateSequenceToString, nullptr if there is none */
+    Context* findContextForKey(const std::string& key);
+/** writes the sent context in the stateSequenceToString format */
+    std::string contextToString(const Context& context);
+/** picks a random observation from the sent context */
+    state_single pickRandomObservation(const Context& context);
 /**
  * returns the available states that follow the sent key, where the sent key 
  * is derived from stateSequenceToString 
  */
-    state_sequence getOptionsForSequenceKey(state_single seqAsKey);
+    state_sequence getOptionsForSequenceKey(std::string seqAsKey);
 
 /**
  * Checks if the sent string is suitable for parsing by fromString: 
@@ -172,12 +319,42 @@ private:
  * does it have at least two commas? 
  */
 static bool validateStateToObservationsString(const std::string& s);
-/**
- * Maps from string keys to list of possible next states
- * 
- */
-    std::map<state_single,state_sequence> model;
+/** true if contexts of the sent order are stored and matched */
+    bool usesOrder(unsigned long order);
+/** true if contexts of the sent order go into the sketch */
+    bool isApproximateOrder(unsigned long order);
+/** picks a continuation of the sketched context, weighted by the estimated counts. false if there is none */
+    bool pickSketchObservation(std::uint64_t hash, bool needChoice, symbol_id& obs);
     unsigned long maxOrder; 
+/** sorted list of orders in use, empty for all of them */
+    std::vector<unsigned long> orders;
+/** orders above this live in sketch, 0 if there is no sketch */
+    unsigned long exactOrderLimit;
+    ContextSketch sketch;
     unsigned long orderOfLastMatch;
-    state_and_observation lastMatch;
+/** sizes the scratch space below to maxOrder */
+    void sizeScratch();
+/** scratch for tryGenerateObservation, kept so that generating does not allocate */
+    std::vector<symbol_id> lookupIds;
+    std::vector<std::uint64_t> lookupHashes;
+/** scratch for addObservationAllOrders, so that training does not allocate either */
+    std::vector<symbol_id> trainIds;
+/** 
+ * the context behind the last generated observation, empty for zero order, 
+ * so getLastMatch only builds a key when it is asked for 
+ */
+    std::vector<symbol_id> lastMatchIds;
+    state_single lastObservation;
+/** optional preallocated block that the arena hands out first */
+    std::unique_ptr<std::byte[]> arenaBuffer;
+    std::size_t arenaBufferSize;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+/**
+ * Maps from contexts to list of possible next states.
+ * declared after the arena so it is destroyed first
+ */
+    std::unique_ptr<Storage> model;
 };
+
+/** the chain of strings used throughout the plugin and the tests */
+typedef BasicMarkovChain<std::string> MarkovChain;
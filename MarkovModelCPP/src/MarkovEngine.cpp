@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    MarkovEngine.cpp
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "MarkovEngine.h"
+#include "SuffixAutomaton.h"
+#include "DenseMarkovChain.h"
+#include "PitchSet.h"
+#include "NoteEvent.h"
+#include <type_traits>
+
+/**
+ * BasicMarkovEngine on top of one of the model classes. They share most of their
+ * calls already, the differences are sorted out here at compile time.
+ */
+template <typename State, typename Model>
+class MarkovEngineAdapter final : public BasicMarkovEngine<State> {
+  public:
+    typedef typename BasicMarkovEngine<State>::state_sequence state_sequence;
+    typedef typename BasicMarkovEngine<State>::state_and_observation state_and_observation;
+    static constexpr bool isChain = std::is_same<Model, BasicMarkovChain<State>>::value;
+    static constexpr bool isAutomaton = std::is_same<Model, BasicSuffixAutomaton<State>>::value;
+
+    template <typename... Args>
+    MarkovEngineAdapter(ModelEngine _type, Args... args) : model{args...}, type{_type}
+    {
+
+    }
+    ModelEngine getType() override
+    {
+      return type;
+    }
+    void addObservationAllOrders(const state_sequence& prevState, const State& currentState) override
+    {
+      // the automaton's context is everything it was sent before
+      if constexpr (isAutomaton) model.addObservation(currentState);
+      else model.addObservationAllOrders(prevState, currentState);
+    }
+    bool usesSentContext() override
+    {
+      return !isAutomaton;
+    }
+    State generateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice) override
+    {
+      return model.generateObservation(prevState, maxOrderWanted, needChoice);
+    }
+    bool tryGenerateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice, State& obs) override
+    {
+      if constexpr (isChain) return model.tryGenerateObservation(prevState, maxOrderWanted, needChoice, obs);
+      else
+      {
+        State sampled = model.generateObservation(prevState, maxOrderWanted, needChoice);
+        if (model.getOrderOfLastMatch() == 0) return false;
+        obs = sampled;
+        return true;
+      }
+    }
+    int getOrderOfLastMatch() override
+    {
+      return model.getOrderOfLastMatch();
+    }
+    state_and_observation getLastMatch() override
+    {
+      return model.getLastMatch();
+    }
+    void removeMapping(const std::string& stateKey, const State& unwanted) override
+    {
+      model.removeMapping(stateKey, unwanted);
+    }
+    void amplifyMapping(const std::string& stateKey, const State& wanted) override
+    {
+      model.amplifyMapping(stateKey, wanted);
+    }
+    std::string toString() override
+    {
+      return model.toString();
+    }
+    bool fromString(const std::string& savedModel) override
+    {
+      return model.fromString(savedModel);
+    }
+    BasicMarkovChain<State> toMarkovChain() override
+    {
+      if constexpr (isChain) return model;
+      else
+      {
+        BasicMarkovChain<State> chain{};
+        if constexpr (!isAutomaton) chain.fromString(model.toString());
+        return chain;
+      }
+    }
+    long size() override
+    {
+      return model.size();
+    }
+    float getRandomness() override
+    {
+      return model.getRandomness();
+    }
+    void setRandomness(float randomness) override
+    {
+      model.randomness = randomness;
+    }
+    void setOrders(const std::vector<unsigned long>& orders) override
+    {
+      model.setOrders(orders);
+    }
+    std::vector<unsigned long> getOrders() override
+    {
+      return model.getOrders();
+    }
+    void setExactOrderLimit(unsigned long order) override
+    {
+      if constexpr (isChain) model.setExactOrderLimit(order);
+    }
+    void reserveMemory(std::size_t bytes) override
+    {
+      if constexpr (isChain) model.reserveMemory(bytes);
+    }
+    void reset() override
+    {
+      model.reset();
+    }
+
+  private:
+    Model model;
+    ModelEngine type;
+};
+
+template <typename State>
+std::unique_ptr<BasicMarkovEngine<State>> makeMarkovEngine(ModelEngine type, unsigned long maxOrder, std::size_t alphabetSize)
+{
+  switch (type)
+  {
+    case ModelEngine::suffixAutomaton:
+      return std::make_unique<MarkovEngineAdapter<State, BasicSuffixAutomaton<State>>>(type, maxOrder);
+    case ModelEngine::denseMatrix:
+      return std::make_unique<MarkovEngineAdapter<State, BasicDenseMarkovChain<State>>>(type, alphabetSize, maxOrder);
+    default:
+      return std::make_unique<MarkovEngineAdapter<State, BasicMarkovChain<State>>>(ModelEngine::markovChain, maxOrder);
+  }
+}
+
+// the state types the engines are built for. Add new state types here
+template std::unique_ptr<BasicMarkovEngine<std::string>> makeMarkovEngine<std::string>(ModelEngine, unsigned long, std::size_t);
+template std::unique_ptr<BasicMarkovEngine<std::uint8_t>> makeMarkovEngine<std::uint8_t>(ModelEngine, unsigned long, std::size_t);
+template std::unique_ptr<BasicMarkovEngine<std::uint32_t>> makeMarkovEngine<std::uint32_t>(ModelEngine, unsigned long, std::size_t);
+template std::unique_ptr<BasicMarkovEngine<PitchSet>> makeMarkovEngine<PitchSet>(ModelEngine, unsigned long, std::size_t);
+template std::unique_ptr<BasicMarkovEngine<NoteEvent>> makeMarkovEngine<NoteEvent>(ModelEngine, unsigned long, std::size_t);
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    MarkovEngine.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "MarkovChain.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Which structure stores a model.
+ * markovChain keeps one key per order and is the reference engine. suffixAutomaton keeps the
+ * training sequence in linear memory and is better suited to high orders
+ * and long training sessions. denseMatrix keeps orders up to 2 in count tables
+ * for small alphabets such as MIDI velocities.
+ */
+enum class ModelEngine { markovChain, suffixAutomaton, denseMatrix };
+
+/**
+ * What BasicMarkovManager and JointEventModel need from a model store, so the store can be
+ * picked at runtime with makeMarkovEngine and compared against the others without
+ * touching the code that uses it. See BasicMarkovChain for what each call does.
+ */
+template <typename State>
+class BasicMarkovEngine {
+  public:
+    typedef State state_single;
+    typedef std::vector<State> state_sequence;
+    typedef std::pair<std::string, State> state_and_observation;
+
+    virtual ~BasicMarkovEngine() = default;
+    virtual ModelEngine getType() = 0;
+
+    /** observe: learn currentState following every order of prevState */
+    virtual void addObservationAllOrders(const state_sequence& prevState, const state_single& currentState) = 0;
+    /**
+     * false for engines that learn one continuous sequence and ignore the prevState
+     * they are sent, so they can't learn several interleaved sequences
+     */
+    virtual bool usesSentContext() = 0;
+
+    /** query: sample a continuation, backing off down to zero order */
+    virtual state_single generateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice=false) = 0;
+    /** query without the zero order fallback. false, leaving obs alone, if no order above zero matched */
+    virtual bool tryGenerateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice, state_single& obs) = 0;
+    virtual int getOrderOfLastMatch() = 0;
+    virtual state_and_observation getLastMatch() = 0;
+
+    /** feedback on a key from getLastMatch */
+    virtual void removeMapping(const std::string& stateKey, const state_single& unwanted) = 0;
+    virtual void amplifyMapping(const std::string& stateKey, const state_single& wanted) = 0;
+
+    /** serialise */
+    virtual std::string toString() = 0;
+    virtual bool fromString(const std::string& savedModel) = 0;
+    /** the model as the reference engine. Engines that do not save in its format give an empty chain */
+    virtual BasicMarkovChain<State> toMarkovChain() = 0;
+
+    /** stats: number of contexts, or of observations for the suffix automaton */
+    virtual long size() = 0;
+
+    virtual float getRandomness() = 0;
+    virtual void setRandomness(float randomness) = 0;
+    virtual void setOrders(const std::vector<unsigned long>& orders) = 0;
+    /** the orders in use, as set with setOrders or loaded by fromString. empty if all orders are in use */
+    virtual std::vector<unsigned long> getOrders() = 0;
+    /** see BasicMarkovChain::setExactOrderLimit. Ignored by engines with bounded memory of their own */
+    virtual void setExactOrderLimit(unsigned long order) = 0;
+    /** see BasicMarkovChain::reserveMemory. Ignored by engines that do not use an arena */
+    virtual void reserveMemory(std::size_t bytes) = 0;
+    virtual void reset() = 0;
+};
+
+/**
+ * creates an empty model of the sent type. alphabetSize is the number of
+ * symbols the dense engine has room for, the other engines ignore it
+ */
+template <typename State>
+std::unique_ptr<BasicMarkovEngine<State>> makeMarkovEngine(ModelEngine type, unsigned long maxOrder, std::size_t alphabetSize=128);
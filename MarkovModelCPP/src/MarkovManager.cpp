@@ -9,69 +9,115 @@
 */
 
 #include "MarkovManager.h"
+#include "PitchSet.h"
+#include "RealtimeLog.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 
-MarkovManager::MarkovManager(unsigned long maxOrder, unsigned long chainEventMemoryLength) 
+template <typename State>
+BasicMarkovManager<State>::BasicMarkovManager(unsigned long _maxOrder, unsigned long chainEventMemoryLength, ModelEngine engine) 
   : maxChainEventMemory{chainEventMemoryLength}, 
   chainEventIndex{0}, 
-  locked{false}
+  locked{false},
+  maxOrder{_maxOrder},
+  exactOrderLimit{0},
+  reservedBytes{0},
+  model{makeMarkovEngine<State>(engine, _maxOrder, denseAlphabetSize)}
 {
-  inputMemory.assign(maxOrder, "0");
-  outputMemory.assign(maxOrder, "0");
+  inputMemory.assign(maxOrder, traits::blank());
+  outputMemory.assign(maxOrder, traits::blank());
   
 }
-MarkovManager::~MarkovManager()
+template <typename State>
+BasicMarkovManager<State>::~BasicMarkovManager()
 {
   
 }
-void MarkovManager::reset()
+template <typename State>
+void BasicMarkovManager<State>::reset()
 {
   mtx.lock();  
-  inputMemory.assign(inputMemory.size(), "0");
-  outputMemory.assign(outputMemory.size(), "0");
-  chain.reset();
+  inputMemory.assign(inputMemory.size(), traits::blank());
+  outputMemory.assign(outputMemory.size(), traits::blank());
+  model->reset();
   mtx.unlock();
 }
-void MarkovManager::putEvent(state_single event)
+template <typename State>
+void BasicMarkovManager<State>::reserveMemory(std::size_t bytes)
+{
+  mtx.lock();
+  if (bytes > reservedBytes) reservedBytes = bytes;
+  model->reserveMemory(bytes);
+  mtx.unlock();
+}
+template <typename State>
+void BasicMarkovManager<State>::setOrders(const std::vector<unsigned long>& _orders)
+{
+  mtx.lock();
+  orders = _orders;
+  model->setOrders(orders);
+  fitMemoryToOrders();
+  mtx.unlock();
+}
+template <typename State>
+void BasicMarkovManager<State>::fitMemoryToOrders()
+{
+  unsigned long highest = 0;
+  for (const unsigned long& order : orders) if (order > highest) highest = order;
+  // pad with blanks at the old end so the most recent events stay put
+  if (highest > inputMemory.size()) inputMemory.insert(inputMemory.begin(), highest - inputMemory.size(), traits::blank());
+  if (highest > outputMemory.size()) outputMemory.insert(outputMemory.begin(), highest - outputMemory.size(), traits::blank());
+}
+template <typename State>
+void BasicMarkovManager<State>::setExactOrderLimit(unsigned long order)
+{
+  mtx.lock();
+  exactOrderLimit = order;
+  model->setExactOrderLimit(order);
+  mtx.unlock();
+}
+template <typename State>
+void BasicMarkovManager<State>::putEvent(state_single event)
 {
   mtx.lock();
   try{
   // add the observation to the markov 
   // note that when we are boostrapping, i.e. filling up the input memory
   // we should not pass states in that include the "0"
-  chain.addObservationAllOrders(inputMemory, event);
+  model->addObservationAllOrders(inputMemory, event);
   // update the input memory
   addStateToStateSequence(inputMemory, event);
   }catch(...){// put this here as my JUCE thing crashes due to lack of thread-safeness
-    std::cout << "MarkovManager::putEvent crashed... catching" << std::endl;
+    MARKOV_LOG(error, "MarkovManager::putEvent crashed... catching", 1000);
   }  
   mtx.unlock();
 }
-state_single MarkovManager::getEvent(bool needChoices)
+template <typename State>
+State BasicMarkovManager<State>::getEvent(bool needChoices)
 {
   mtx.lock();
-  state_single event{""};
+  state_single event = traits::blank();
 
   try{
     // get an observation
-    event = chain.generateObservation(outputMemory, outputMemory.size(), needChoices);
+    event = model->generateObservation(outputMemory, outputMemory.size(), needChoices);
     // check the output
     // update the outputMemory
     addStateToStateSequence(outputMemory, event);
     // store the event in case we want to provide negative or positive feedback to the chain
     // later
-    rememberChainEvent(chain.getLastMatch());
+    rememberChainEvent(model->getLastMatch());
   }catch(...){// put this here as my JUCE thing crashes due to lack of thread-safeness
-    std::cout << "MarkovManager::getEvent crashed... catching" << std::endl;
-    event = "0";
+    MARKOV_LOG(error, "MarkovManager::getEvent crashed... catching", 1000);
+    event = traits::blank();
   }
   mtx.unlock();
   return event;
 }
 
-void MarkovManager::addStateToStateSequence(state_sequence& seq, state_single new_state){
+template <typename State>
+void BasicMarkovManager<State>::addStateToStateSequence(state_sequence& seq, state_single new_state){
   // shift everything across
   for (long unsigned int i=1;i<seq.size();i++)
   {
@@ -81,17 +127,72 @@ void MarkovManager::addStateToStateSequence(state_sequence& seq, state_single ne
   seq[seq.size()-1] = new_state;
 }
 
-int MarkovManager::getOrderOfLastEvent()
+template <typename State>
+int BasicMarkovManager<State>::getOrderOfLastEvent()
 {
-  return chain.getOrderOfLastMatch();
+  mtx.lock();
+  int order = model->getOrderOfLastMatch();
+  mtx.unlock();
+  return order;
 }
 
-float MarkovManager::getRandomness(){
-  return chain.getRandomness();
+template <typename State>
+float BasicMarkovManager<State>::getRandomness(){
+  mtx.lock();
+  float randomness = model->getRandomness();
+  mtx.unlock();
+  return randomness;
 }
 
+template <typename State>
+void BasicMarkovManager<State>::setRandomness(float randomness)
+{
+  mtx.lock();
+  model->setRandomness(randomness);
+  mtx.unlock();
+}
 
-void MarkovManager::rememberChainEvent(state_and_observation sObs)
+template <typename State>
+void BasicMarkovManager<State>::setEngine(ModelEngine engine)
+{
+  mtx.lock();
+  if (engine != model->getType())
+  {
+    std::unique_ptr<BasicMarkovEngine<State>> next = makeMarkovEngine<State>(engine, maxOrder, denseAlphabetSize);
+    next->setRandomness(model->getRandomness());
+    if (orders.size() > 0) next->setOrders(orders);
+    if (exactOrderLimit > 0) next->setExactOrderLimit(exactOrderLimit);
+    if (reservedBytes > 0) next->reserveMemory(reservedBytes);
+    if (model->usesSentContext() && next->usesSentContext()) next->fromString(model->toString());
+    model = std::move(next);
+    // the keys remembered for feedback belong to the old engine
+    chainEvents.clear();
+    chainEventIndex = 0;
+  }
+  mtx.unlock();
+}
+
+template <typename State>
+ModelEngine BasicMarkovManager<State>::getEngine()
+{
+  mtx.lock();
+  ModelEngine engine = model->getType();
+  mtx.unlock();
+  return engine;
+}
+
+template <typename State>
+long BasicMarkovManager<State>::size()
+{
+  mtx.lock();
+  long count = model->size();
+  mtx.unlock();
+  return count;
+}
+
+
+template <typename State>
+void BasicMarkovManager<State>::rememberChainEvent(state_and_observation sObs)
 {
   // the memory of chain events is not full yet
   if (chainEvents.size() < maxChainEventMemory)
@@ -106,26 +207,33 @@ void MarkovManager::rememberChainEvent(state_and_observation sObs)
   }
 }
 
-void MarkovManager::giveNegativeFeedback()
+template <typename State>
+void BasicMarkovManager<State>::giveNegativeFeedback()
 {
+  mtx.lock();
   // remove all recently used mappings
   for (state_and_observation& so : chainEvents)
   {
-    chain.removeMapping(so.first, so.second);
+    model->removeMapping(so.first, so.second);
   }
+  mtx.unlock();
 }
 
 
-void MarkovManager::givePositiveFeedback()
+template <typename State>
+void BasicMarkovManager<State>::givePositiveFeedback()
 {
+  mtx.lock();
   // amplify all recently used mappings
   for (state_and_observation& so : chainEvents)
   {
-    chain.amplifyMapping(so.first, so.second);
+    model->amplifyMapping(so.first, so.second);
   }
+  mtx.unlock();
 }
 
-bool MarkovManager::loadModel(const std::string& filename)
+template <typename State>
+bool BasicMarkovManager<State>::loadModel(const std::string& filename)
 {
   if (std::ifstream in {filename})
   {
@@ -133,39 +241,58 @@ bool MarkovManager::loadModel(const std::string& filename)
     sstr << in.rdbuf();
     std::string data = sstr.str();
     in.close();
-    return chain.fromString(data);
+    return setupModelFromString(data);
   }
   else {
     return false; 
   }
 }
 
-bool MarkovManager::saveModel(const std::string& filename)
+template <typename State>
+bool BasicMarkovManager<State>::saveModel(const std::string& filename)
 {
     if (std::ofstream ofs{filename}){
-      ofs << chain.toString();
+      ofs << getModelAsString();
       ofs.close();
       return true; 
     }
     else {
-      std::cout << "MarkovManager::saveModel failed to save to file " << filename << std::endl;
+      MARKOV_LOG_VALUE(error, "MarkovManager::saveModel failed to save to file", filename.c_str(), 0);
       return false; 
     }
 }
 
-std::string MarkovManager::getModelAsString()
+template <typename State>
+std::string BasicMarkovManager<State>::getModelAsString()
 {
-  return chain.toString();
+  mtx.lock();
+  std::string modelData = model->toString();
+  mtx.unlock();
+  return modelData;
 }
 
-bool MarkovManager::setupModelFromString(std::string modelData)
+template <typename State>
+bool BasicMarkovManager<State>::setupModelFromString(std::string modelData)
 {
-  return chain.fromString(modelData);
+  mtx.lock();
+  bool loaded = model->fromString(modelData);
+  // an orders: line in the saved model replaces the engine's orders
+  orders = model->getOrders();
+  fitMemoryToOrders();
+  mtx.unlock();
+  return loaded;
 }
 
-MarkovChain MarkovManager::getCopyOfModel()
+template <typename State>
+BasicMarkovChain<State> BasicMarkovManager<State>::getCopyOfModel()
 {
-  return chain;
+  mtx.lock();
+  BasicMarkovChain<State> copy = model->toMarkovChain();
+  mtx.unlock();
+  return copy;
 }
 
-
+template class BasicMarkovManager<std::string>;
+template class BasicMarkovManager<std::uint8_t>;
+template class BasicMarkovManager<std::uint32_t>;
+template class BasicMarkovManager<PitchSet>;
@@ -10,21 +10,31 @@
 
 #pragma once
 #include "MarkovChain.h"
+#include "MarkovEngine.h"
+#include <memory>
 #include <mutex>
 
-
 /**
- * Manages a markov chain for training and generation purposes
+ * Manages a markov chain for training and generation purposes. 
+ * State is the type of the events, see BasicMarkovChain.
+ * MarkovManager manages strings.
  */
-class MarkovManager {
+template <typename State>
+class BasicMarkovManager {
   public:
+      typedef State state_single;
+      typedef std::vector<State> state_sequence;
+      typedef std::pair<std::string, State> state_and_observation;
+      typedef StateTraits<State> traits;
+
   /**
    * Create a markov manager. chainEventMemoryLength is how many chain events we 
    * remember. Chain events are remembered so we can delete or amplify parts of the chain
    * using givePositive and giveNegative feedback. 
+   * engine selects the underlying storage, see setEngine. 
    */
-      MarkovManager(unsigned long maxOrder=100, unsigned long chainEventMemoryLength=20);
-      ~MarkovManager();
+      BasicMarkovManager(unsigned long maxOrder=100, unsigned long chainEventMemoryLength=20, ModelEngine engine=ModelEngine::markovChain);
+      ~BasicMarkovManager();
       /** add an event to the chain. The manager manages previous events to ensure 
        * that variable orders are passed to the underlying markov model
       */
@@ -40,12 +50,42 @@ class MarkovManager {
        */
       int getOrderOfLastEvent();
 
-      float MarkovManager::getRandomness();
+      float getRandomness();
+      void setRandomness(float randomness);
+      /**
+       * switch the underlying storage, e.g. to compare engines on the same material.
+       * The orders, exact order limit and reserved memory carry over. So does the model
+       * between the engines that save in the same format (markovChain and denseMatrix),
+       * otherwise it starts empty. Everything that reaches the model takes the manager's lock,
+       * so it is safe to switch while other threads use the manager.
+       */
+      void setEngine(ModelEngine engine);
+      ModelEngine getEngine();
+      /** the size of the underlying model, see BasicMarkovEngine::size */
+      long size();
       
       /**
        * wipe the underlying model and reset short term input and output memory. 
        */
       void reset();
+      /**
+       * preallocate 'bytes' of storage for the underlying model so training 
+       * can run without calling the system allocator. Not real-time safe itself:
+       * call it from e.g. prepareToPlay
+       */
+      void reserveMemory(std::size_t bytes);
+      /**
+       * only use the sent orders, e.g. {1, 2, 4, 8}, rather than every order up to maxOrder. 
+       * Worth it for attributes like velocity where long contexts rarely help but 
+       * still cost memory. The input and output memories grow if the highest order needs it.
+       */
+      void setOrders(const std::vector<unsigned long>& orders);
+      /**
+       * store contexts longer than 'order' approximately, in fixed memory. 
+       * See BasicMarkovChain::setExactOrderLimit. The suffix automaton is already
+       * linear in the length of the training sequence so it ignores this. 
+       */
+      void setExactOrderLimit(unsigned long order);
 
       /**
        * Rotates the sent seq and pops the sent item on the end
@@ -76,16 +116,22 @@ class MarkovManager {
        * in case you don't want to use saveModel directly
       */
       std::string getModelAsString();
-      /** tries to convert the sent string into a model by calling model.fromString */
+      /**
+       * tries to convert the sent string into a model by calling model.fromString.
+       * Orders saved with the model replace the current ones, as setOrders
+       */
       bool setupModelFromString(std::string);
 
 
-      /** returns a copy of the model */
-      MarkovChain getCopyOfModel();
+      /** returns a copy of the model as a BasicMarkovChain, see BasicMarkovEngine::toMarkovChain */
+      BasicMarkovChain<State> getCopyOfModel();
 
-      MarkovChain chain;
+      /** symbols the dense engine has room for: all the MIDI values */
+      static constexpr std::size_t denseAlphabetSize = 128;
   private:
       void rememberChainEvent(state_and_observation event);
+      /** make the memories long enough for the highest of orders. called with mtx held */
+      void fitMemoryToOrders();
       
       state_sequence inputMemory;
       state_sequence outputMemory;
@@ -94,6 +140,13 @@ class MarkovManager {
       unsigned long  maxChainEventMemory;
       unsigned long  chainEventIndex;
       bool locked;
+      unsigned long maxOrder;
+      /** the settings sent so far, for when the engine is switched */
+      std::vector<unsigned long> orders;
+      unsigned long exactOrderLimit;
+      std::size_t reservedBytes;
+      std::unique_ptr<BasicMarkovEngine<State>> model;
       std::mutex mtx;
 };
 
+typedef BasicMarkovManager<std::string> MarkovManager;
@@ -1,12 +1,35 @@
 
 #include "MarkovChain.h"
 #include "MarkovManager.h"
+#include "SuffixAutomaton.h"
+#include "ContextSketch.h"
+#include "ContextTable.h"
+#include "FixedOrderMarkovChain.h"
+#include "DenseMarkovChain.h"
+#include "PitchSet.h"
+#include "RelativePitchEncoder.h"
+#include "TimeQuantiser.h"
+#include "MarkovEngine.h"
+#include "JointEventModel.h"
+#include "TranspositionAugmenter.h"
+#include "NoteOffScheduler.h"
+#include "ScaleTables.h"
+#include "KeyDetector.h"
+#include "RealtimeLog.h"
 //#include "dinvernoSystem.h"
 //#include "../JuceLibraryCode/JuceHeader.h"
 
 #include <iostream>
 #include <string>
 #include <random>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <sstream>
 
 /**
  * helper function to print result of a test
@@ -17,6 +40,51 @@ void log(std::string test, bool result)
     std::cout << test << " : " << result << std::endl;
 }
 
+/**
+ * counts every call to the global operator new, so a test 
+ * can check that something does not allocate
+ */
+static std::atomic<std::size_t> allocationCount{0};
+
+void* operator new(std::size_t size)
+{
+    allocationCount ++;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc{};
+}
+
+// kept out of line, or gcc sees free() paired with new where it gets inlined
+[[gnu::noinline]] void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// the arenas reach the system allocator through the aligned forms
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    allocationCount ++;
+    std::size_t align = (std::size_t) alignment;
+    // aligned_alloc wants a whole number of alignments
+    std::size_t rounded = (size == 0 ? 1 : size + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, rounded == 0 ? align : rounded)) return p;
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
 
 // 1
 bool emptyChainReturnsNull()
@@ -748,6 +816,960 @@ bool allSame(){
     else return true; 
 }
 
+bool reserveKeepsModel()
+{
+    MarkovChain chain{};
+    chain.addObservation(state_sequence{"a", "b"}, "c");
+    std::string before = chain.toString();
+    chain.reserveMemory(1024 * 64);
+    if (chain.getReservedMemory() != 1024 * 64) return false;
+    if (chain.toString() != before) return false;
+    // should still be able to train and query from the new arena
+    chain.addObservation(state_sequence{"c"}, "d");
+    if (chain.generateObservation(state_sequence{"c"}, 1) != "d") return false;
+    return true;
+}
+
+bool resetReleasesArena()
+{
+    MarkovManager man{};
+    man.reserveMemory(1024 * 64);
+    for (auto i=0;i<1000;++i){
+        man.putEvent("s_"+std::to_string(i % 10));
+    }
+    man.reset();
+    if (man.getCopyOfModel().size() != 0) return false;
+    man.putEvent("x");
+    man.putEvent("y");
+    if (man.getCopyOfModel().size() != 1) return false; 
+    return true;
+}
+
+bool allOrdersToString()
+{
+    MarkovChain m{};
+    m.addObservationAllOrders(state_sequence{"a", "b"}, "c");
+    m.addObservationAllOrders(state_sequence{"b", "c"}, "a");
+    // contexts point into the shared event log but export as before
+    std::string got = m.toString();
+    std::string want{"1,b,:1,c,\n1,c,:1,a,\n2,a,b,:1,c,\n2,b,c,:1,a,\n"};
+    if (got == want) return true;
+    std::cout << "Wanted: "<<want<<" got " << got << std::endl;
+    return false; 
+}
+
+bool allOrdersSkipsBlanks()
+{
+    MarkovChain m{};
+    // same as the manager does when it is bootstrapping
+    m.addObservationAllOrders(state_sequence{"0", "0", "a"}, "b");
+    m.addObservationAllOrders(state_sequence{"0", "a", "b"}, "c");
+    if (m.size() != 3) return false;
+    if (m.generateObservation(state_sequence{"a", "b"}, 2) != "c") return false;
+    if (m.getOrderOfLastMatch() != 2) return false;
+    return true; 
+}
+
+bool automatonReturnsContinuation()
+{
+    SuffixAutomaton sa{};
+    sa.addObservation("a");
+    sa.addObservation("b");
+    sa.addObservation("c");
+    state_single res = sa.generateObservation(state_sequence{"a", "b"}, 2);
+    if (res == "c" && sa.getOrderOfLastMatch() == 2) return true;
+    return false; 
+}
+
+bool automatonBacksOff()
+{
+    SuffixAutomaton sa{};
+    state_sequence seq = {"a", "b", "c", "a", "b", "d"};
+    for (state_single& s : seq) sa.addObservation(s);
+    // x,a,b was never seen but a,b was, twice 
+    bool seenC = false;
+    bool seenD = false;
+    for (auto i=0;i<100;i++)
+    {
+        state_single res = sa.generateObservation(state_sequence{"x", "a", "b"}, 3, true);
+        if (sa.getOrderOfLastMatch() != 2) return false; 
+        if (res == "c") seenC = true;
+        if (res == "d") seenD = true;
+    }
+    return seenC && seenD; 
+}
+
+bool automatonRespectsMaxOrder()
+{
+    SuffixAutomaton sa{2};
+    state_sequence seq = {"a", "b", "c", "d"};
+    for (state_single& s : seq) sa.addObservation(s);
+    sa.generateObservation(state_sequence{"a", "b", "c"}, 3);
+    if (sa.getOrderOfLastMatch() == 2) return true;
+    return false; 
+}
+
+bool automatonRemoveMapping()
+{
+    SuffixAutomaton sa{};
+    sa.addObservation("a");
+    sa.addObservation("b");
+    sa.generateObservation(state_sequence{"a"}, 1);
+    state_and_observation last = sa.getLastMatch();
+    if (last.second != "b") return false;
+    sa.removeMapping(last.first, last.second);
+    // a->b has gone so it has to back off to zero order
+    sa.generateObservation(state_sequence{"a"}, 1);
+    if (sa.getOrderOfLastMatch() == 0) return true;
+    return false; 
+}
+
+bool automatonToStringFromString()
+{
+    SuffixAutomaton sa{};
+    state_sequence seq = {"a", "b", "c", "a", "b", "d"};
+    for (state_single& s : seq) sa.addObservation(s);
+    sa.generateObservation(state_sequence{"a", "b"}, 2);
+    state_and_observation last = sa.getLastMatch();
+    sa.amplifyMapping(last.first, last.second);
+    std::string want = sa.toString();
+    SuffixAutomaton sa2{};
+    sa2.fromString(want);
+    std::string got = sa2.toString();
+    if (got == want) return true;
+    std::cout << "Wanted: "<<want<<" got " << got << std::endl;
+    return false; 
+}
+
+bool automatonManagerHighOrder()
+{
+    MarkovManager man{200, 20, ModelEngine::suffixAutomaton};
+    for (auto i=0; i<10000; ++i){
+        man.putEvent("s_"+std::to_string(i % 7));
+    }
+    // the training sequence is periodic so once the output memory 
+    // has filled up it should find a long match
+    for (auto i=0;i<150;i++) man.getEvent();
+    if (man.getOrderOfLastEvent() < 100) return false; 
+    man.giveNegativeFeedback();
+    man.givePositiveFeedback();
+    man.saveModel("test_automaton.txt");
+    MarkovManager man2{200, 20, ModelEngine::suffixAutomaton};
+    man2.loadModel("test_automaton.txt");
+    return man2.getModelAsString() == man.getModelAsString(); 
+}
+
+bool chainOrderSetSkipsOrders()
+{
+    MarkovChain chain{};
+    chain.setOrders({3, 1});
+    chain.addObservationAllOrders(state_sequence{"a", "b", "c"}, "d");
+    // orders 1 and 3 only
+    if (chain.size() != 2) return false;
+    chain.generateObservation(state_sequence{"a", "b", "c"}, 10);
+    if (chain.getOrderOfLastMatch() != 3) return false;
+    // order 2 would match here, but it is not stored
+    chain.generateObservation(state_sequence{"x", "b", "c"}, 10);
+    if (chain.getOrderOfLastMatch() != 1) return false;
+    return true;
+}
+
+bool chainOrderSetToStringFromString()
+{
+    MarkovChain chain{};
+    chain.setOrders({1, 2, 4});
+    chain.addObservationAllOrders(state_sequence{"a", "b", "c", "d"}, "e");
+    std::string want = chain.toString();
+    MarkovChain chain2{};
+    chain2.fromString(want);
+    std::string got = chain2.toString();
+    if (got == want && chain2.getOrders().size() == 3) return true;
+    std::cout << "Wanted: "<<want<<" got " << got << std::endl;
+    return false; 
+}
+
+bool automatonOrderSet()
+{
+    SuffixAutomaton sa{};
+    state_sequence seq = {"a", "b", "c", "d"};
+    for (state_single& s : seq) sa.addObservation(s);
+    sa.setOrders({1, 3});
+    sa.generateObservation(state_sequence{"a", "b", "c"}, 10);
+    if (sa.getOrderOfLastMatch() != 3) return false;
+    sa.generateObservation(state_sequence{"x", "b", "c"}, 10);
+    if (sa.getOrderOfLastMatch() != 1) return false;
+    return true;
+}
+
+bool managerOrderSet()
+{
+    MarkovManager man{};
+    man.setOrders({1, 2, 4, 8});
+    for (auto i=0; i<100; ++i){
+        man.putEvent("s_"+std::to_string(i % 5));
+    }
+    for (auto i=0;i<20;i++){
+        man.getEvent();
+        int order = man.getOrderOfLastEvent();
+        if (order != 0 && order != 1 && order != 2 && order != 4 && order != 8) return false;
+    }
+    return true;
+}
+
+bool managerLoadsOrders()
+{
+    MarkovManager saved{2};
+    saved.setOrders({1, 6});
+    // the manager it loads into only keeps two events until it sees the orders
+    MarkovManager man{2};
+    if (!man.setupModelFromString(saved.getModelAsString())) return false;
+    for (auto i=0; i<100; ++i){
+        man.putEvent("s_"+std::to_string(i % 7));
+    }
+    bool usedSix = false;
+    for (auto i=0;i<20;i++){
+        man.getEvent(false);
+        int order = man.getOrderOfLastEvent();
+        if (order != 0 && order != 1 && order != 6) return false;
+        if (order == 6) usedSix = true;
+    }
+    return usedSix;
+}
+
+bool sketchCountsAndCandidates()
+{
+    ContextSketch sketch{1024};
+    sketch.add(12345, 1);
+    sketch.add(12345, 1);
+    sketch.add(12345, 2);
+    std::uint32_t candidates[ContextSketch::candidatesPerContext];
+    if (sketch.getCandidates(12345, candidates) != 2) return false;
+    // count-min never underestimates
+    if (sketch.estimate(12345, 1) < 2) return false;
+    if (sketch.getCandidates(999, candidates) != 0) return false;
+    sketch.removeCandidate(12345, 1);
+    if (sketch.getCandidates(12345, candidates) != 1 || candidates[0] != 2) return false;
+    return true;
+}
+
+bool hybridChainRecallsLongContext()
+{
+    MarkovChain chain{};
+    chain.setExactOrderLimit(2, 4096);
+    chain.addObservationAllOrders(state_sequence{"a", "b", "c", "d"}, "e");
+    // only orders 1 and 2 are exact
+    if (chain.size() != 2) return false;
+    state_single obs = chain.generateObservation(state_sequence{"a", "b", "c", "d"}, 10);
+    if (obs != "e" || chain.getOrderOfLastMatch() != 4) return false;
+    // the key can be used for feedback like any other
+    if (chain.getLastMatch().first != "4,a,b,c,d,") return false;
+    chain.removeMapping(chain.getLastMatch().first, "e");
+    // so now it backs off to order 3, which is also sketched
+    chain.generateObservation(state_sequence{"a", "b", "c", "d"}, 10);
+    if (chain.getOrderOfLastMatch() != 3) return false;
+    return true;
+}
+
+bool hybridChainFixedMemory()
+{
+    MarkovManager man{};
+    man.setExactOrderLimit(4);
+    for (auto i=0; i<2000; ++i){
+        man.putEvent("s_"+std::to_string(i % 50));
+    }
+    // exact contexts are bounded by 50 symbols * 4 orders
+    if (man.size() > 200) return false;
+    for (auto i=0;i<100;i++) man.getEvent();
+    // a periodic sequence should be recalled beyond the exact orders
+    return man.getOrderOfLastEvent() > 4;
+}
+
+bool typedChainMatchesStringChain()
+{
+    MarkovChain strings{};
+    BasicMarkovChain<std::uint8_t> bytes{};
+    strings.addObservationAllOrders(state_sequence{"64", "80", "100"}, "64");
+    bytes.addObservationAllOrders(std::vector<std::uint8_t>{64, 80, 100}, 64);
+    // same text, so saved models are interchangeable
+    if (strings.toString() != bytes.toString()) return false;
+    if (bytes.generateObservation(std::vector<std::uint8_t>{64, 80, 100}, 3) != 64) return false;
+    return bytes.getOrderOfLastMatch() == 3;
+}
+
+bool typedManagerSaveLoad()
+{
+    BasicMarkovManager<std::uint32_t> man{};
+    for (std::uint32_t i=0; i<50; ++i) man.putEvent(22050 + (i % 3) * 100);
+    std::string want = man.getModelAsString();
+    BasicMarkovManager<std::uint32_t> man2{};
+    man2.setupModelFromString(want);
+    if (man2.getModelAsString() != want) return false;
+    std::uint32_t ioi = man2.getEvent();
+    return ioi == 22050 || ioi == 22150 || ioi == 22250;
+}
+
+bool fixedOrderChainBacksOff()
+{
+    FixedOrderMarkovChain<std::uint8_t, 4> chain{};
+    chain.addObservation(std::array<std::uint8_t, 4>{10, 20, 30, 40}, 50);
+    chain.addObservation(std::array<std::uint8_t, 4>{0, 0, 0, 40}, 60);
+    if (chain.generateObservation(std::array<std::uint8_t, 4>{10, 20, 30, 40}) != 50) return false;
+    if (chain.getOrderOfLastMatch() != 4) return false;
+    // only the most recent symbol matches, which has two options
+    std::uint8_t obs = chain.generateObservation(std::array<std::uint8_t, 4>{99, 99, 99, 40});
+    if (obs != 50 && obs != 60) return false;
+    if (chain.getOrderOfLastMatch() != 1) return false;
+    // needChoice pushes order 4 (one option) down to order 1
+    chain.generateObservation(std::array<std::uint8_t, 4>{10, 20, 30, 40}, true);
+    return chain.getOrderOfLastMatch() == 1;
+}
+
+bool denseChainBacksOffToDenseOrders()
+{
+    BasicDenseMarkovChain<std::uint8_t> chain{128, 4};
+    std::vector<std::uint8_t> memory = {10, 20, 30, 40};
+    chain.addObservationAllOrders(memory, 50);
+    // order 4 lives in the sparse chain
+    if (chain.generateObservation(memory, 4) != 50 || chain.getOrderOfLastMatch() != 4) return false;
+    // only the last two symbols match, which is a dense order
+    if (chain.generateObservation(std::vector<std::uint8_t>{1, 2, 30, 40}, 4) != 50) return false;
+    if (chain.getOrderOfLastMatch() != 2) return false;
+    return chain.getLastMatch().first == "2,30,40,";
+}
+
+bool denseChainSamplesWholeRow()
+{
+    BasicDenseMarkovChain<std::uint8_t> chain{128, 2};
+    std::vector<std::uint8_t> memory = {1};
+    // 60 options, so the search crosses many blocks of four, with weights 1 to 60
+    for (std::uint8_t obs = 2; obs < 62; ++obs){
+        for (std::uint8_t i = 0; i < obs - 1; ++i) chain.addObservationAllOrders(memory, obs);
+    }
+    std::vector<int> seen(128, 0);
+    for (auto i=0; i<20000; ++i) seen[chain.generateObservation(memory, 1)] ++;
+    if (chain.getOrderOfLastMatch() != 1) return false;
+    for (auto obs = 0; obs < 128; ++obs){
+        bool expected = obs >= 2 && obs < 62;
+        if (expected != (seen[obs] > 0)) return false;
+    }
+    // the heaviest option should come up far more than the lightest
+    return seen[61] > seen[2] * 10;
+}
+
+bool denseChainSavesAsMarkovChain()
+{
+    MarkovManager sparse{4};
+    MarkovManager dense{4, 20, ModelEngine::denseMatrix};
+    state_sequence seq = {"60", "62", "64", "60", "62", "67", "60", "62", "64"};
+    for (state_single& s : seq){
+        sparse.putEvent(s);
+        dense.putEvent(s);
+    }
+    // a dense model loads the sparse one and the other way round
+    MarkovManager dense2{4, 20, ModelEngine::denseMatrix};
+    dense2.setupModelFromString(sparse.getModelAsString());
+    if (dense2.getModelAsString() != dense.getModelAsString()) return false;
+    MarkovChain chain{};
+    chain.fromString(dense.getModelAsString());
+    return chain.size() == sparse.size();
+}
+
+bool denseChainRemoveMapping()
+{
+    BasicDenseMarkovChain<std::uint8_t> chain{128, 2};
+    std::vector<std::uint8_t> memory = {1};
+    chain.addObservationAllOrders(memory, 2);
+    chain.addObservationAllOrders(memory, 3);
+    chain.removeMapping("1,1,", 2);
+    for (auto i=0; i<100; ++i){
+        if (chain.generateObservation(memory, 1) != 3) return false;
+    }
+    return true;
+}
+
+bool pitchSetIsCanonical()
+{
+    PitchSet a{std::vector<int>{67, 60, 64}};
+    PitchSet b{std::vector<int>{60, 64, 67, 64}};
+    if (a != b || PitchSet::Hash{}(a) != PitchSet::Hash{}(b)) return false;
+    if (a.toString() != "60-64-67-") return false;
+    // notes either side of the word boundary and at the ends of the range
+    PitchSet edges{std::vector<int>{127, 64, 0, 63}};
+    if (edges.toNotes() != std::vector<int>{0, 63, 64, 127}) return false;
+    if (PitchSet::fromString("67-60-64-") != a) return false;
+    return PitchSet::fromString("0").empty() && PitchSet{}.toString() == "0";
+}
+
+bool pitchSetModelSavesAsNoteStrings()
+{
+    BasicMarkovManager<PitchSet> chords{};
+    MarkovManager strings{};
+    std::vector<std::vector<int>> played = {{64, 60, 67}, {62, 65}, {60, 64, 67}, {65, 62}};
+    for (const std::vector<int>& notes : played){
+        PitchSet chord{notes};
+        chords.putEvent(chord);
+        strings.putEvent(chord.toString());
+    }
+    if (chords.getModelAsString() != strings.getModelAsString()) return false;
+    // the two voicings of each chord are one state
+    if (chords.getCopyOfModel().generateObservation({PitchSet{std::vector<int>{60, 64, 67}}}, 1) != PitchSet{std::vector<int>{62, 65}}) return false;
+    BasicMarkovManager<PitchSet> loaded{};
+    loaded.setupModelFromString(strings.getModelAsString());
+    return loaded.getModelAsString() == chords.getModelAsString();
+}
+
+bool relativePitchIgnoresKey()
+{
+    std::vector<std::vector<int>> lick = {{60, 64, 67}, {62}, {64}, {65, 69}, {67}, {62, 65, 69}, {59, 62, 67}, {60}};
+    BasicMarkovManager<PitchSet> relative{4};
+    BasicMarkovManager<PitchSet> absolute{4};
+    RelativePitchEncoder encoder{};
+    // the same lick in four keys
+    for (int shift : {0, 2, 5, 7}){
+        for (const std::vector<int>& chord : lick){
+            std::vector<int> transposed{};
+            for (int note : chord) transposed.push_back(note + shift);
+            relative.putEvent(encoder.encode(PitchSet{transposed}));
+            absolute.putEvent(PitchSet{transposed});
+        }
+    }
+    // after the first time through, only the steps into each key are new
+    return relative.size() * 2 < absolute.size();
+}
+
+bool relativePitchRoundTrip()
+{
+    std::vector<std::vector<int>> played = {{60, 64, 67}, {48}, {50, 53}, {74, 77, 81}, {72, 76}};
+    RelativePitchEncoder learn{};
+    RelativePitchEncoder play{};
+    // seed the generator with the first chord played
+    play.encode(PitchSet{played[0]});
+    for (size_t i = 0; i < played.size(); ++i){
+        PitchSet decoded = play.decode(learn.encode(PitchSet{played[i]}));
+        if (i > 0 && decoded != PitchSet{played[i]}) return false;
+    }
+    // a step off the top of the range comes back down an octave
+    PitchSet high = RelativePitchEncoder::fromIntervals(RelativePitchEncoder::toIntervals(PitchSet{std::vector<int>{126, 130}}, 120), 124);
+    PitchSet low = RelativePitchEncoder::fromIntervals(RelativePitchEncoder::toIntervals(PitchSet{std::vector<int>{10, 14}}, 20), 3);
+    return high.highest() <= 127 && low.lowest() >= 0 && low.contains(5) && low.contains(9);
+}
+
+bool timeQuantiserIgnoresSampleRate()
+{
+    TimeQuantiser at44{TimeQuantiser::Mode::logarithmic, 44100.0};
+    TimeQuantiser at96{TimeQuantiser::Mode::logarithmic, 96000.0};
+    for (double seconds : {0.05, 0.125, 0.25, 0.3, 1.0, 1.9}){
+        std::uint32_t bin = at44.quantise((unsigned long) (seconds * 44100));
+        if (bin != at96.quantise((unsigned long) (seconds * 96000))) return false;
+        if (bin < 1 || bin > TimeQuantiser::maxBin) return false;
+    }
+    // bins keep the order of the times
+    return at44.quantise(4410) < at44.quantise(8820);
+}
+
+bool timeQuantiserTempoGrid()
+{
+    TimeQuantiser grid{TimeQuantiser::Mode::tempoGrid, 48000.0};
+    grid.setTempo(120.0);
+    // a beat is half a second, twelve divisions
+    if (grid.quantise(24000) != 12) return false;
+    // a slightly late eighth note: bin 6, played back as late as it was
+    if (grid.quantise(12600) != 6) return false;
+    if (grid.dequantise(6) != 12600) return false;
+    // a bin nobody has played comes back at its centre, at the new tempo
+    grid.setTempo(60.0);
+    if (grid.dequantise(3) != 12000) return false;
+    TimeQuantiser loaded{};
+    if (!loaded.fromString(grid.toString())) return false;
+    loaded.setSampleRate(48000.0);
+    loaded.setTempo(120.0);
+    return loaded.getMode() == TimeQuantiser::Mode::tempoGrid && loaded.dequantise(6) == 12600;
+}
+
+NoteEvent makeNoteEvent(std::vector<int> notes, int iOI, int duration, int velocity)
+{
+    NoteEvent event{};
+    event.pitches = PitchSet{notes};
+    event.iOI = (std::uint8_t) iOI;
+    event.duration = (std::uint8_t) duration;
+    event.velocity = (std::uint8_t) velocity;
+    return event;
+}
+
+bool jointModelKeepsAttributesTogether()
+{
+    JointEventModel model{4};
+    // high chords are always loud and short, low ones soft and long
+    for (auto i=0; i<20; ++i){
+        if (rand() % 2 == 0) model.putEvent(makeNoteEvent({72, 76}, 6, 3, 120));
+        else model.putEvent(makeNoteEvent({48, 55}, 12, 10, 30));
+    }
+    for (auto i=0; i<50; ++i){
+        NoteEvent event = model.getEvent();
+        if (event.pitches.lowest() == 72 && (event.velocity != 120 || event.duration != 3)) return false;
+        if (event.pitches.lowest() == 48 && (event.velocity != 30 || event.duration != 10)) return false;
+    }
+    return true;
+}
+
+bool jointModelFactorisedBackoff()
+{
+    JointEventModel model{4};
+    model.setFactorisedBackoff(true);
+    // the pitches go round a cycle but the velocities never repeat,
+    // so no joint context has a choice and the joint model can only pick at zero order
+    std::vector<std::vector<int>> cycle = {{60}, {64}, {67}};
+    for (auto i=0; i<30; ++i) model.putEvent(makeNoteEvent(cycle[i % 3], 4, 4, 10 + i));
+    NoteEvent previous = model.getEvent();
+    for (auto i=0; i<20; ++i){
+        NoteEvent event = model.getEvent();
+        if (model.getOrderOfLastEvent() < 1) return false;
+        // the pitch follows the cycle and the attributes are ones seen with it
+        int next = cycle[(std::find(cycle.begin(), cycle.end(), previous.pitches.toNotes()) - cycle.begin() + 1) % 3][0];
+        if (event.pitches.lowest() != next || (event.velocity - 10) % 3 != (next == 60 ? 0 : next == 64 ? 1 : 2)) return false;
+        previous = event;
+    }
+    return true;
+}
+
+bool jointModelSaveLoad()
+{
+    JointEventModel model{4};
+    model.setFactorisedBackoff(true);
+    model.putEvent(makeNoteEvent({60, 64, 67}, 12, 6, 100));
+    model.putEvent(makeNoteEvent({62}, 6, 3, 80));
+    model.putEvent(makeNoteEvent({60, 64, 67}, 12, 6, 90));
+    JointEventModel loaded{4};
+    if (!loaded.setupModelFromString(model.getModelAsString())) return false;
+    return loaded.getModelAsString() == model.getModelAsString() && loaded.size() == model.size();
+}
+
+bool pitchSetShiftedDropsOutOfRange()
+{
+    PitchSet chord{std::vector<int>{60, 63, 127}};
+    // 60 and 63 cross from the low word to the high one
+    if (chord.shifted(4) != PitchSet{std::vector<int>{64, 67}}) return false;
+    if (chord.shifted(-60) != PitchSet{std::vector<int>{0, 3, 67}}) return false;
+    if (chord.shifted(-61) != PitchSet{std::vector<int>{2, 66}}) return false;
+    return chord.shifted(0) == chord && chord.shifted(128).empty() && chord.shifted(-128).empty();
+}
+
+bool augmenterLearnsOtherKeys()
+{
+    JointEventModel plain{4};
+    JointEventModel augmented{4};
+    {
+        TranspositionAugmenter augmenter{augmented, 3};
+        augmenter.setTranspositions({2, 5, 7});
+        for (int i = 0; i < 3; ++i)
+        {
+            for (NoteEvent event : {makeNoteEvent({60, 64, 67}, 12, 6, 100), makeNoteEvent({62}, 6, 3, 80), makeNoteEvent({65, 69}, 6, 3, 90)})
+            {
+                plain.putEvent(event);
+                augmented.putEvent(event);
+                if (!augmenter.push(event)) return false;
+            }
+        }
+        augmenter.flush();
+    }
+    std::string model = augmented.getModelAsString();
+    // each key follows its own path, so the model is four times the size
+    return augmented.size() == plain.size() * 4 &&
+        model.find("62-66-69-/") != std::string::npos &&
+        model.find("67-71-74-/") != std::string::npos &&
+        plain.getModelAsString().find("62-66-69-/") == std::string::npos;
+}
+
+bool contextTableKeepsCollisionsApart()
+{
+    ContextTable table{std::pmr::new_delete_resource()};
+    // every entry shares one of four fingerprints, and there are enough to grow the table a few times
+    for (std::uint32_t n = 0; n < 1000; ++n) table.insert(n % 4, n);
+    if (table.size() != 1000) return false;
+    for (std::uint32_t n = 0; n < 1000; ++n)
+    {
+        if (table.find(n % 4, [n](std::uint32_t number){ return number == n; }) != n) return false;
+    }
+    return table.find(5, [](std::uint32_t){ return true; }) == ContextTable::notFound;
+}
+
+bool chainFindsContextsAfterGrowing()
+{
+    BasicMarkovChain<std::uint32_t> chain{2};
+    for (std::uint32_t i = 1; i < 5000; ++i) chain.addObservation({i, i + 1}, i + 2);
+    BasicMarkovChain<std::uint32_t> copy{chain};
+    for (std::uint32_t i = 1; i < 5000; ++i)
+    {
+        if (chain.generateObservation({i, i + 1}, 2) != i + 2 || chain.getOrderOfLastMatch() != 2) return false;
+        if (copy.generateObservation({i, i + 1}, 2) != i + 2 || copy.getOrderOfLastMatch() != 2) return false;
+    }
+    return chain.size() == 4999 && copy.toString() == chain.toString();
+}
+
+bool managerSwitchesEngine()
+{
+    MarkovManager man{4};
+    MarkovManager dense{4, 20, ModelEngine::denseMatrix};
+    state_sequence seq = {"60", "62", "64", "60", "62", "67", "60", "62", "64"};
+    for (state_single& s : seq){
+        man.putEvent(s);
+        dense.putEvent(s);
+    }
+    man.setRandomness(0.5f);
+    // the dense engine reads and writes the chain's format, so the model comes across
+    man.setEngine(ModelEngine::denseMatrix);
+    if (man.getEngine() != ModelEngine::denseMatrix || man.getRandomness() != 0.5f) return false;
+    if (man.getModelAsString() != dense.getModelAsString()) return false;
+    man.putEvent("60");
+    if (man.getEvent(false) == "0") return false;
+    // the automaton does not, so it starts again
+    man.setEngine(ModelEngine::suffixAutomaton);
+    if (man.size() != 0) return false;
+    man.putEvent("60");
+    return man.size() == 1 && man.getCopyOfModel().size() == 0;
+}
+
+bool jointModelOnEveryEngine()
+{
+    std::vector<NoteEvent> phrase = {makeNoteEvent({60, 64, 67}, 12, 6, 100), makeNoteEvent({62}, 6, 3, 80),
+                                     makeNoteEvent({64, 67}, 6, 3, 90), makeNoteEvent({65}, 12, 6, 70)};
+    for (ModelEngine engine : {ModelEngine::markovChain, ModelEngine::suffixAutomaton, ModelEngine::denseMatrix})
+    {
+        JointEventModel model{4, engine};
+        // joint events outgrow the dense tables, so the chain stands in for them
+        ModelEngine expected = engine == ModelEngine::denseMatrix ? ModelEngine::markovChain : engine;
+        if (model.getEngine() != expected) return false;
+        for (int i = 0; i < 4; ++i)
+            for (const NoteEvent& event : phrase) model.putEvent(event);
+        // every context has one continuation, so it plays the phrase back
+        NoteEvent first = model.getEvent(false);
+        std::size_t at = 0;
+        while (at < phrase.size() && phrase[at] != first) at ++;
+        if (at == phrase.size()) return false;
+        for (int i = 1; i < 8; ++i)
+        {
+            if (model.getEvent(false) != phrase[(at + i) % phrase.size()]) return false;
+        }
+    }
+    return true;
+}
+
+bool noteOffSchedulerOnlyReturnsDueOffs()
+{
+    NoteOffScheduler offs{};
+    offs.schedule(64, 1500);
+    offs.schedule(60, 1100);
+    offs.schedule(67, 900);
+    NoteOffScheduler::NoteOff due{};
+    // a block from 512 to 1024
+    if (!offs.popDue(1024, due) || due.note != 67 || due.time != 900) return false;
+    if (offs.popDue(1024, due)) return false;
+    // the next block, in time order
+    if (!offs.popDue(1536, due) || due.note != 60) return false;
+    if (!offs.popDue(1536, due) || due.note != 64) return false;
+    return !offs.popDue(NoteOffScheduler::never, due) && offs.nextTime() == NoteOffScheduler::never;
+}
+
+bool noteOffSchedulerReplacesRetriggeredNote()
+{
+    NoteOffScheduler offs{};
+    offs.schedule(60, 100);
+    // played again while still sounding: the caller turns it off, then schedules the new off
+    if (!offs.isPending(60) || !offs.cancel(60)) return false;
+    offs.schedule(60, 300);
+    NoteOffScheduler::NoteOff due{};
+    if (offs.popDue(200, due)) return false;
+    if (!offs.popDue(400, due) || due.time != 300) return false;
+    // old entries make room for new ones when the heap fills up
+    for (int i = 0; i < 1000; ++i) if (!offs.schedule(127, i)) return false;
+    return offs.schedule(0, 5000) && offs.nextTime() == 999 && !offs.schedule(128, 10);
+}
+
+bool jointModelGeneratesWithoutAllocating()
+{
+    std::vector<NoteEvent> phrase = {makeNoteEvent({60, 64, 67}, 12, 6, 100), makeNoteEvent({62}, 6, 3, 80),
+                                     makeNoteEvent({64, 67}, 6, 3, 90), makeNoteEvent({65}, 12, 6, 70),
+                                     makeNoteEvent({62}, 6, 3, 60), makeNoteEvent({60, 64, 67}, 24, 12, 100)};
+    for (ModelEngine engine : {ModelEngine::markovChain, ModelEngine::suffixAutomaton, ModelEngine::denseMatrix})
+    {
+        // set up as the plugin does, with the sketch and the factorised models in use
+        JointEventModel model{8, engine};
+        model.setExactOrderLimit(2);
+        model.setFactorisedBackoff(true);
+        for (int i = 0; i < 20; ++i)
+            for (std::size_t j = 0; j < phrase.size(); ++j) model.putEvent(phrase[(j * (i % 3 + 1)) % phrase.size()]);
+        std::size_t before = allocationCount;
+        for (int i = 0; i < 500; ++i) model.getEvent(i % 2 == 0);
+        if (allocationCount != before) return false;
+    }
+    return true;
+}
+
+bool scaleTablesHoldTheKeys()
+{
+    const ScaleTables::NoteTable& cMajor = ScaleTables::scales[0];
+    for (int note : {60, 62, 64, 65, 67, 69, 71, 72}) if (!cMajor.contains(note)) return false;
+    if (cMajor.contains(61) || cMajor.contains(128) || cMajor.count != 75) return false;
+    // A minor has the notes of its relative major
+    for (int note = 0; note < 128; ++note)
+    {
+        if (ScaleTables::scales[21].contains(note) != cMajor.contains(note)) return false;
+    }
+    // B# is in C# major
+    if (!ScaleTables::scales[1].contains(0)) return false;
+    // C minor's chord has the minor third
+    return ScaleTables::chords[12].contains(63) && !ScaleTables::chords[12].contains(64);
+}
+
+bool scaleStepsMatchWalkingTheNotes()
+{
+    for (const auto* tables : {&ScaleTables::scales, &ScaleTables::chords})
+    {
+        for (const ScaleTables::NoteTable& table : *tables)
+        {
+            for (int note = 0; note < 128; ++note)
+            {
+                for (int steps = 1; steps <= 4; ++steps)
+                {
+                    // walk a note at a time, as the generator used to
+                    int up = -1, down = -1;
+                    for (int n = note + 1, found = 0; n < 128 && up == -1; ++n) if (table.contains(n) && ++found == steps) up = n;
+                    for (int n = note - 1, found = 0; n >= 0 && down == -1; --n) if (table.contains(n) && ++found == steps) down = n;
+                    if (table.stepUp(note, steps) != up || table.stepDown(note, steps) != down) return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool keyDetectorFindsTheKey()
+{
+    KeyDetector detector{1000.0, 30.0};
+    if (detector.detectKey() != -1) return false;
+    // a C major scale and arpeggio
+    unsigned long time = 0;
+    for (int note : {60, 62, 64, 65, 67, 69, 71, 72, 67, 64, 60}) detector.addNote(note, time += 250);
+    if (detector.detectKey() != 0) return false;
+    // A minor, leaning on A and E, with the raised seventh
+    detector.reset();
+    for (int note : {57, 60, 64, 69, 68, 69, 64, 60, 57, 59, 57}) detector.addNote(note, time += 250);
+    return detector.detectKey() == 21;
+}
+
+bool keyDetectorFollowsModulation()
+{
+    KeyDetector detector{1000.0, 2.0};
+    unsigned long time = 0;
+    // up the scale with the tonic chord underneath
+    auto play = [&](int key, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            detector.addNote(ScaleTables::scales[key].notes[35 + i % 7], time += 50);
+            detector.addNote(ScaleTables::chords[key].notes[15 + i % 3], time);
+        }
+    };
+    // long enough in C major for the weights to be folded back, then a while in F# major
+    play(0, 4000);
+    if (detector.detectKey() != 0) return false;
+    play(6, 200);
+    if (detector.detectKey() != 6) return false;
+    // and it comes back through a save
+    KeyDetector loaded{};
+    if (!loaded.fromString(detector.toString())) return false;
+    if (loaded.fromString("1,2,") || loaded.detectKey() != 6) return false;
+    loaded.setKey(17);
+    return loaded.detectKey() == 17;
+}
+
+bool realtimeLogWritesRecords()
+{
+    auto realtime = std::make_unique<RealtimeLog>();
+    RealtimeLog::Site values{RealtimeLog::Level::warning, "block overran"};
+    RealtimeLog::Site detail{RealtimeLog::Level::error, "could not open"};
+    RealtimeLog::Site quiet{RealtimeLog::Level::debug, "every block"};
+    // writing is off the heap, so it can go on the audio thread
+    std::size_t before = allocationCount;
+    if (!realtime->write(values, 3, -4)) return false;
+    if (!realtime->write(detail, "a/file/name/that/is/far/too/long/to/fit/in/a/record.txt")) return false;
+    if (realtime->write(quiet)) return false;
+    if (allocationCount != before) return false;
+    realtime->setLevel(RealtimeLog::Level::debug);
+    if (!realtime->write(quiet, 7)) return false;
+    std::string text;
+    if (realtime->drain(text) != 3) return false;
+    return text.find("[warning]") != std::string::npos &&
+           text.find("block overran: 3, -4\n") != std::string::npos &&
+           text.find("could not open: a/file/name/that/is/far/too/long/to/fit/in/a/re\n") != std::string::npos &&
+           text.find("[debug]") != std::string::npos &&
+           text.find("every block: 7\n") != std::string::npos &&
+           realtime->drain(text) == 0;
+}
+
+bool realtimeLogRateLimits()
+{
+    auto realtime = std::make_unique<RealtimeLog>();
+    RealtimeLog::Site site{RealtimeLog::Level::info, "buffer full", 200};
+    int written = 0;
+    for (int i = 0; i < 5; ++i) if (realtime->write(site)) written ++;
+    if (written != 1) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    if (!realtime->write(site)) return false;
+    std::string text;
+    if (realtime->drain(text) != 2) return false;
+    return text.find("buffer full (4 suppressed)") != std::string::npos;
+}
+
+bool realtimeLogDropsWhenFull()
+{
+    auto realtime = std::make_unique<RealtimeLog>();
+    RealtimeLog::Site site{RealtimeLog::Level::info, "note"};
+    for (std::size_t i = 0; i < RealtimeLog::capacity; ++i) if (!realtime->write(site, (std::int64_t) i)) return false;
+    for (int i = 0; i < 10; ++i) if (realtime->write(site)) return false;
+    if (realtime->getDropped() != 10) return false;
+    std::string text;
+    if (realtime->drain(text) != RealtimeLog::capacity) return false;
+    // oldest first, and there is room again once it is read
+    if (text.find("note: 0\n") != text.find("note: ")) return false;
+    if (!realtime->write(site, 99)) return false;
+    text.clear();
+    return realtime->drain(text) == 1 && text.find("note: 99") != std::string::npos;
+}
+
+bool realtimeLogCountsStarts()
+{
+    // truncate what an earlier run left, as start appends
+    std::ofstream{"test_realtime_log.txt"};
+    auto realtime = std::make_unique<RealtimeLog>();
+    RealtimeLog::Site site{RealtimeLog::Level::info, "second user"};
+    realtime->start("test_realtime_log.txt");
+    realtime->start("ignored.txt");
+    // the first user going leaves the thread running for the second
+    realtime->stop();
+    if (!realtime->write(site, 2)) return false;
+    realtime->stop();
+    // one too many stops does nothing
+    realtime->stop();
+    std::ifstream in{"test_realtime_log.txt"};
+    std::stringstream text;
+    text << in.rdbuf();
+    return text.str().find("second user: 2\n") != std::string::npos;
+}
+
+bool reserveCoversMemoryFor()
+{
+    const int events = 5000;
+    const unsigned long order = 8;
+    BasicMarkovChain<NoteEvent> chain{order};
+    chain.reserveMemory(BasicMarkovChain<NoteEvent>::memoryFor(events, order));
+    std::vector<NoteEvent> memory(order, NoteEvent{});
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<> value(1, 120);
+    std::size_t allocations = 0;
+    // nearly every event, and so every context, is new: the worst case
+    for (int i = 0; i < events; ++i){
+        NoteEvent event = makeNoteEvent({30 + value(gen) % 60}, value(gen) % 90 + 1, 4, value(gen));
+        std::size_t before = allocationCount;
+        chain.addObservationAllOrders(memory, event);
+        allocations += allocationCount - before;
+        memory.erase(memory.begin());
+        memory.push_back(event);
+    }
+    return allocations == 0;
+}
+
+bool jointModelSizeFollowsChanges()
+{
+    JointEventModel model{4};
+    if (model.size() != 0) return false;
+    // read from another thread while the model learns, as the editor's status does
+    std::atomic<bool> learning{true};
+    long largest = 0;
+    std::thread reader([&]{ while (learning) largest = std::max(largest, model.size()); });
+    for (auto i=0; i<200; ++i) model.putEvent(makeNoteEvent({60 + i % 12}, 4, 4, 100));
+    learning = false;
+    reader.join();
+    long learnt = model.size();
+    if (learnt <= 0 || largest > learnt) return false;
+    JointEventModel loaded{4};
+    if (!loaded.setupModelFromString(model.getModelAsString()) || loaded.size() != learnt) return false;
+    model.reset();
+    return model.size() == 0;
+}
+
+bool scaleTablesNameTheKeys()
+{
+    return std::string{ScaleTables::keyName(0)} == "C Major" && std::string{ScaleTables::keyName(18)} == "F# Minor" &&
+           std::string{ScaleTables::keyName(-1)} == "" && std::string{ScaleTables::keyName(24)} == "";
+}
+
+bool jointModelTryCallsMatchTheBlockingOnes()
+{
+    JointEventModel blocking{4};
+    JointEventModel trying{4};
+    std::vector<NoteEvent> phrase = {makeNoteEvent({60}, 4, 4, 100), makeNoteEvent({64, 67}, 6, 2, 90), makeNoteEvent({62}, 4, 8, 70)};
+    for (auto i=0; i<30; ++i){
+        blocking.putEvent(phrase[i % 3]);
+        // nothing else has the model, so it never has to back off
+        if (!trying.tryPutEvent(phrase[i % 3])) return false;
+    }
+    if (trying.getModelAsString() != blocking.getModelAsString()) return false;
+    // every event has one event after it, once the first has been drawn
+    NoteEvent previous{};
+    if (!trying.tryGetEvent(previous, false)) return false;
+    for (auto i=0; i<10; ++i){
+        NoteEvent event{};
+        auto at = std::find(phrase.begin(), phrase.end(), previous);
+        if (!trying.tryGetEvent(event, false) || at == phrase.end() || event != phrase[(at - phrase.begin() + 1) % 3]) return false;
+        previous = event;
+    }
+    return true;
+}
+
+bool denseChainLearnsPastItsAlphabet()
+{
+    BasicDenseMarkovChain<std::uint8_t> chain{4, 4};
+    // a cycle of eight symbols, twice what the tables have room for
+    std::vector<std::uint8_t> memory = {5, 6, 7, 8};
+    for (auto i=0; i<40; ++i){
+        std::uint8_t next = (std::uint8_t) (i % 8 + 1);
+        chain.addObservationAllOrders(memory, next);
+        memory.erase(memory.begin());
+        memory.push_back(next);
+    }
+    // the symbols the tables turned away still come back through the sparse orders
+    for (std::uint8_t start = 1; start <= 8; ++start){
+        std::vector<std::uint8_t> context;
+        for (int j = 0; j < 4; ++j) context.push_back((std::uint8_t) ((start + j - 1) % 8 + 1));
+        std::uint8_t expected = (std::uint8_t) ((start + 3) % 8 + 1);
+        if (chain.generateObservation(context, 4) != expected || chain.getOrderOfLastMatch() < 3) return false;
+    }
+    return true;
+}
+
+bool jointModelLearnsPastTheDenseAlphabet()
+{
+    // short enough that the dense engine would keep every order in its tables
+    JointEventModel model{2, ModelEngine::denseMatrix};
+    model.setEngine(ModelEngine::denseMatrix);
+    // 300 distinct events, far more than the dense engine's 128 symbols, in a cycle
+    std::vector<NoteEvent> cycle;
+    for (int i = 0; i < 300; ++i) cycle.push_back(makeNoteEvent({30 + i % 60}, 1 + i / 60, 4, 100));
+    for (int pass = 0; pass < 2; ++pass)
+        for (const NoteEvent& event : cycle) model.putEvent(event);
+    // so every event, the late ones too, follows the one before it
+    NoteEvent previous = model.getEvent(false);
+    for (int i = 0; i < 400; ++i)
+    {
+        auto at = std::find(cycle.begin(), cycle.end(), previous);
+        NoteEvent event = model.getEvent(false);
+        if (at == cycle.end() || event != cycle[(at - cycle.begin() + 1) % cycle.size()]) return false;
+        previous = event;
+    }
+    return model.size() >= 300;
+}
+
 void runMarkovTests()
 {
     int total_tests, passed_tests;
@@ -1027,6 +2049,291 @@ void runMarkovTests()
     log("putAndGetTheSame", res);
     total_tests ++;
     if (res) passed_tests ++;
+
+    res = reserveKeepsModel();
+    log("reserveKeepsModel", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = resetReleasesArena();
+    log("resetReleasesArena", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = allOrdersToString();
+    log("allOrdersToString", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = allOrdersSkipsBlanks();
+    log("allOrdersSkipsBlanks", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = automatonReturnsContinuation();
+    log("automatonReturnsContinuation", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = automatonBacksOff();
+    log("automatonBacksOff", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = automatonRespectsMaxOrder();
+    log("automatonRespectsMaxOrder", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = automatonRemoveMapping();
+    log("automatonRemoveMapping", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = automatonToStringFromString();
+    log("automatonToStringFromString", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = automatonManagerHighOrder();
+    log("automatonManagerHighOrder", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = chainOrderSetSkipsOrders();
+    log("chainOrderSetSkipsOrders", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = chainOrderSetToStringFromString();
+    log("chainOrderSetToStringFromString", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = automatonOrderSet();
+    log("automatonOrderSet", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = managerOrderSet();
+    log("managerOrderSet", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = sketchCountsAndCandidates();
+    log("sketchCountsAndCandidates", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = hybridChainRecallsLongContext();
+    log("hybridChainRecallsLongContext", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = hybridChainFixedMemory();
+    log("hybridChainFixedMemory", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = typedChainMatchesStringChain();
+    log("typedChainMatchesStringChain", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = typedManagerSaveLoad();
+    log("typedManagerSaveLoad", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = fixedOrderChainBacksOff();
+    log("fixedOrderChainBacksOff", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = denseChainBacksOffToDenseOrders();
+    log("denseChainBacksOffToDenseOrders", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = denseChainSamplesWholeRow();
+    log("denseChainSamplesWholeRow", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = denseChainSavesAsMarkovChain();
+    log("denseChainSavesAsMarkovChain", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = denseChainRemoveMapping();
+    log("denseChainRemoveMapping", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = pitchSetIsCanonical();
+    log("pitchSetIsCanonical", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = pitchSetModelSavesAsNoteStrings();
+    log("pitchSetModelSavesAsNoteStrings", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = relativePitchIgnoresKey();
+    log("relativePitchIgnoresKey", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = relativePitchRoundTrip();
+    log("relativePitchRoundTrip", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = timeQuantiserIgnoresSampleRate();
+    log("timeQuantiserIgnoresSampleRate", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = timeQuantiserTempoGrid();
+    log("timeQuantiserTempoGrid", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = jointModelKeepsAttributesTogether();
+    log("jointModelKeepsAttributesTogether", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = jointModelFactorisedBackoff();
+    log("jointModelFactorisedBackoff", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = jointModelSaveLoad();
+    log("jointModelSaveLoad", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = pitchSetShiftedDropsOutOfRange();
+    log("pitchSetShiftedDropsOutOfRange", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = augmenterLearnsOtherKeys();
+    log("augmenterLearnsOtherKeys", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = contextTableKeepsCollisionsApart();
+    log("contextTableKeepsCollisionsApart", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = chainFindsContextsAfterGrowing();
+    log("chainFindsContextsAfterGrowing", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = managerSwitchesEngine();
+    log("managerSwitchesEngine", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = jointModelOnEveryEngine();
+    log("jointModelOnEveryEngine", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = noteOffSchedulerOnlyReturnsDueOffs();
+    log("noteOffSchedulerOnlyReturnsDueOffs", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = noteOffSchedulerReplacesRetriggeredNote();
+    log("noteOffSchedulerReplacesRetriggeredNote", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = jointModelGeneratesWithoutAllocating();
+    log("jointModelGeneratesWithoutAllocating", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = scaleTablesHoldTheKeys();
+    log("scaleTablesHoldTheKeys", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = scaleStepsMatchWalkingTheNotes();
+    log("scaleStepsMatchWalkingTheNotes", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = keyDetectorFindsTheKey();
+    log("keyDetectorFindsTheKey", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = keyDetectorFollowsModulation();
+    log("keyDetectorFollowsModulation", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = realtimeLogWritesRecords();
+    log("realtimeLogWritesRecords", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = realtimeLogRateLimits();
+    log("realtimeLogRateLimits", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = realtimeLogDropsWhenFull();
+    log("realtimeLogDropsWhenFull", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = jointModelSizeFollowsChanges();
+    log("jointModelSizeFollowsChanges", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = scaleTablesNameTheKeys();
+    log("scaleTablesNameTheKeys", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = jointModelTryCallsMatchTheBlockingOnes();
+    log("jointModelTryCallsMatchTheBlockingOnes", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = denseChainLearnsPastItsAlphabet();
+    log("denseChainLearnsPastItsAlphabet", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = jointModelLearnsPastTheDenseAlphabet();
+    log("jointModelLearnsPastTheDenseAlphabet", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = realtimeLogCountsStarts();
+    log("realtimeLogCountsStarts", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = managerLoadsOrders();
+    log("managerLoadsOrders", res);
+    total_tests ++;
+    if (res) passed_tests ++;
+
+    res = reserveCoversMemoryFor();
+    log("reserveCoversMemoryFor", res);
+    total_tests ++;
+    if (res) passed_tests ++;
 }
 
 int main(){
@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    NoteEvent.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "PitchSet.h"
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Everything about one chord that the improviser learns, as a single state:
+ * the notes, the TimeQuantiser bins of the time since the previous chord and of its length,
+ * and its velocity. Modelling them together keeps them in step, e.g. loud chords
+ * stay with the notes that were played loud.
+ * An event with no notes is the blank.
+ */
+struct NoteEvent {
+  PitchSet pitches;
+  std::uint8_t iOI = 0;
+  std::uint8_t duration = 0;
+  std::uint8_t velocity = 0;
+
+  /** the attributes other than pitch in one word, for hashing */
+  std::uint32_t packedAttributes() const
+  {
+    return (std::uint32_t{iOI} << 16) | (std::uint32_t{duration} << 8) | velocity;
+  }
+  bool operator==(const NoteEvent& other) const
+  {
+    return pitches == other.pitches && packedAttributes() == other.packedAttributes();
+  }
+  bool operator!=(const NoteEvent& other) const
+  {
+    return !(*this == other);
+  }
+
+  struct Hash {
+    std::size_t operator()(const NoteEvent& event) const
+    {
+      return PitchSet::Hash{}(event.pitches) ^ (std::size_t) (event.packedAttributes() * 0x9E3779B97F4A7C15ull);
+    }
+  };
+};
+
+/** saved as pitches/iOI/duration/velocity, e.g. "60-64-67-/12/6/100", with "0" as the blank */
+template <>
+struct StateTraits<NoteEvent> {
+  typedef NoteEvent stored_type;
+  typedef NoteEvent lookup_type;
+  typedef NoteEvent::Hash hash;
+  static NoteEvent blank() { return NoteEvent{}; }
+  static bool isBlank(const NoteEvent& state) { return state.pitches.empty(); }
+  static std::string toString(const NoteEvent& state)
+  {
+    if (isBlank(state)) return "0";
+    return state.pitches.toString() + "/" + std::to_string(state.iOI) + "/" + std::to_string(state.duration) + "/" + std::to_string(state.velocity);
+  }
+  static NoteEvent fromString(const std::string& text)
+  {
+    NoteEvent event{};
+    std::size_t slash = text.find('/');
+    event.pitches = PitchSet::fromString(text.substr(0, slash));
+    if (slash == std::string::npos || event.pitches.empty()) return NoteEvent{};
+    char* end;
+    event.iOI = (std::uint8_t) std::strtoul(text.c_str() + slash + 1, &end, 10);
+    if (*end == '/') event.duration = (std::uint8_t) std::strtoul(end + 1, &end, 10);
+    if (*end == '/') event.velocity = (std::uint8_t) std::strtoul(end + 1, &end, 10);
+    return event;
+  }
+};
@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    NoteOffScheduler.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+/**
+ * Pending note offs for generated notes, kept in a fixed size min-heap on their time in samples,
+ * so each block only looks at the offs that are due, and an idle block costs one comparison.
+ * Nothing is allocated, so it is safe on the audio thread.
+ *
+ * Each note has at most one pending off. Cancelling or rescheduling a note leaves its old
+ * entry in the heap, and it is skipped when it comes up.
+ */
+class NoteOffScheduler {
+  public:
+    /** entries the heap has room for, including cancelled ones waiting to come up */
+    static constexpr std::size_t capacity = 256;
+    static constexpr unsigned long never = std::numeric_limits<unsigned long>::max();
+
+    struct NoteOff {
+      unsigned long time;
+      std::uint8_t note;
+    };
+
+    NoteOffScheduler()
+    {
+      clear();
+    }
+    /**
+     * turn the note off at the sent time, replacing any off it already had.
+     * returns false if the note is out of range or the heap is full
+     */
+    bool schedule(std::uint8_t note, unsigned long time)
+    {
+      if (note > 127) return false;
+      if (count == capacity) dropCancelled();
+      if (count == capacity) return false;
+      pending[note] = time;
+      heap[count ++] = Entry{time, note};
+      std::push_heap(heap.begin(), heap.begin() + count, later);
+      return true;
+    }
+    /** true if the note is sounding with an off to come */
+    bool isPending(std::uint8_t note) const
+    {
+      return note <= 127 && pending[note] != never;
+    }
+    /** forget the note's pending off. returns true if there was one */
+    bool cancel(std::uint8_t note)
+    {
+      if (!isPending(note)) return false;
+      pending[note] = never;
+      return true;
+    }
+    /** when the next off is due, never if there are none */
+    unsigned long nextTime()
+    {
+      skipCancelled();
+      return count > 0 ? heap[0].time : never;
+    }
+    /**
+     * takes the earliest off that is due before end, e.g. the end of the block.
+     * returns false if there are none
+     */
+    bool popDue(unsigned long end, NoteOff& due)
+    {
+      skipCancelled();
+      if (count == 0 || heap[0].time >= end) return false;
+      due = NoteOff{heap[0].time, heap[0].note};
+      pending[due.note] = never;
+      pop();
+      return true;
+    }
+    /** forget every pending off */
+    void clear()
+    {
+      count = 0;
+      pending.fill(never);
+    }
+
+  private:
+    struct Entry {
+      unsigned long time;
+      std::uint8_t note;
+    };
+    /** the heap comparison, which puts the earliest entry on top */
+    static bool later(const Entry& a, const Entry& b)
+    {
+      return a.time > b.time;
+    }
+    /** true if the entry is the note's current off */
+    bool isCurrent(const Entry& entry) const
+    {
+      return pending[entry.note] == entry.time;
+    }
+    void pop()
+    {
+      std::pop_heap(heap.begin(), heap.begin() + count, later);
+      count --;
+    }
+    /** pop cancelled and replaced entries off the top */
+    void skipCancelled()
+    {
+      while (count > 0 && !isCurrent(heap[0])) pop();
+    }
+    /** rebuild the heap from only the current entries */
+    void dropCancelled()
+    {
+      std::size_t kept = 0;
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        if (isCurrent(heap[i])) heap[kept ++] = heap[i];
+      }
+      count = kept;
+      std::make_heap(heap.begin(), heap.begin() + count, later);
+    }
+
+    std::array<Entry, capacity> heap;
+    std::size_t count;
+    /** the time of each note's current off, never if it has none */
+    std::array<unsigned long, 128> pending;
+};
@@ -0,0 +1,228 @@
+/*
+  ==============================================================================
+
+    PitchSet.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "StateTraits.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * The set of MIDI notes sounding in a chord, kept as 128 bits: one per note number.
+ * The same notes give the same set whatever order they were played in,
+ * and comparing or hashing a set is a couple of word operations.
+ * Iterating goes up from the lowest note, one bit scan per note.
+ */
+class PitchSet {
+  public:
+    PitchSet() : bits{0, 0} {}
+    /** the set of the sent notes, anything outside 0-127 is ignored */
+    explicit PitchSet(const std::vector<int>& notes) : bits{0, 0}
+    {
+      for (const int& note : notes) add(note);
+    }
+
+    void add(int note)
+    {
+      if (note < 0 || note > 127) return;
+      bits[note >> 6] |= std::uint64_t{1} << (note & 63);
+    }
+    void remove(int note)
+    {
+      if (note < 0 || note > 127) return;
+      bits[note >> 6] &= ~(std::uint64_t{1} << (note & 63));
+    }
+    bool contains(int note) const
+    {
+      if (note < 0 || note > 127) return false;
+      return (bits[note >> 6] >> (note & 63)) & 1;
+    }
+    bool empty() const
+    {
+      return (bits[0] | bits[1]) == 0;
+    }
+    /** the lowest note, or -1 if the set is empty */
+    int lowest() const
+    {
+      if (bits[0] != 0) return lowestBit(bits[0]);
+      if (bits[1] != 0) return 64 + lowestBit(bits[1]);
+      return -1;
+    }
+    /** the highest note, or -1 if the set is empty */
+    int highest() const
+    {
+      if (bits[1] != 0) return 64 + highestBit(bits[1]);
+      if (bits[0] != 0) return highestBit(bits[0]);
+      return -1;
+    }
+    /** how many notes are in the set */
+    int size() const
+    {
+      return popCount(bits[0]) + popCount(bits[1]);
+    }
+
+    bool operator==(const PitchSet& other) const
+    {
+      return bits[0] == other.bits[0] && bits[1] == other.bits[1];
+    }
+    bool operator!=(const PitchSet& other) const
+    {
+      return !(*this == other);
+    }
+
+    /** walks the notes from lowest to highest, clearing one bit per step */
+    class const_iterator {
+      public:
+        const_iterator(std::uint64_t low, std::uint64_t high) : remaining{low, high}, word{low != 0 ? 0 : 1} {}
+        int operator*() const
+        {
+          return word * 64 + lowestBit(remaining[word]);
+        }
+        const_iterator& operator++()
+        {
+          remaining[word] &= remaining[word] - 1;
+          if (word == 0 && remaining[0] == 0) word = 1;
+          return *this;
+        }
+        bool operator!=(const const_iterator& other) const
+        {
+          return remaining[0] != other.remaining[0] || remaining[1] != other.remaining[1];
+        }
+      private:
+        std::uint64_t remaining[2];
+        int word;
+    };
+    const_iterator begin() const { return const_iterator{bits[0], bits[1]}; }
+    const_iterator end() const { return const_iterator{0, 0}; }
+
+    /** the set moved up (or down, if negative) by the sent number of semitones. Notes that fall outside 0-127 are dropped */
+    PitchSet shifted(int semitones) const
+    {
+      PitchSet out{};
+      if (semitones >= 128 || semitones <= -128) return out;
+      if (semitones == 0) return *this;
+      if (semitones > 0)
+      {
+        if (semitones >= 64)
+        {
+          out.bits[1] = bits[0] << (semitones - 64);
+        }
+        else
+        {
+          out.bits[1] = (bits[1] << semitones) | (bits[0] >> (64 - semitones));
+          out.bits[0] = bits[0] << semitones;
+        }
+      }
+      else
+      {
+        int down = -semitones;
+        if (down >= 64)
+        {
+          out.bits[0] = bits[1] >> (down - 64);
+        }
+        else
+        {
+          out.bits[0] = (bits[0] >> down) | (bits[1] << (64 - down));
+          out.bits[1] = bits[1] >> down;
+        }
+      }
+      return out;
+    }
+
+    /** the notes, lowest first */
+    std::vector<int> toNotes() const
+    {
+      std::vector<int> notes{};
+      notes.reserve(size());
+      for (int note : *this) notes.push_back(note);
+      return notes;
+    }
+    /** writes the set as the note strings the plugin used to use, e.g. "60-64-67-", or "0" if empty */
+    std::string toString() const
+    {
+      if (empty()) return "0";
+      std::string s{};
+      for (int note : *this) s += std::to_string(note) + "-";
+      return s;
+    }
+    /** reads a string such as "60-64-67-". Notes can be in any order */
+    static PitchSet fromString(const std::string& text)
+    {
+      PitchSet set{};
+      const char* pos = text.c_str();
+      while (*pos != '\0')
+      {
+        char* next;
+        long note = std::strtol(pos, &next, 10);
+        if (next == pos) break;
+        // "0" on its own is the blank
+        if (!(note == 0 && *next == '\0' && pos == text.c_str())) set.add((int) note);
+        pos = (*next == '-') ? next + 1 : next;
+      }
+      return set;
+    }
+
+    struct Hash {
+      std::size_t operator()(const PitchSet& set) const
+      {
+        std::uint64_t x = set.bits[0] ^ (set.bits[1] * 0x9E3779B97F4A7C15ull);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        return (std::size_t) (x ^ (x >> 31));
+      }
+    };
+
+  private:
+    static int lowestBit(std::uint64_t x)
+    {
+#if defined(_MSC_VER)
+      unsigned long index;
+      _BitScanForward64(&index, x);
+      return (int) index;
+#else
+      return __builtin_ctzll(x);
+#endif
+    }
+    static int highestBit(std::uint64_t x)
+    {
+#if defined(_MSC_VER)
+      unsigned long index;
+      _BitScanReverse64(&index, x);
+      return (int) index;
+#else
+      return 63 - __builtin_clzll(x);
+#endif
+    }
+    static int popCount(std::uint64_t x)
+    {
+#if defined(_MSC_VER)
+      return (int) __popcnt64(x);
+#else
+      return __builtin_popcountll(x);
+#endif
+    }
+
+    std::uint64_t bits[2];
+};
+
+/** chords as pitch sets, saved in the "60-64-67-" format, with the empty set as the blank */
+template <>
+struct StateTraits<PitchSet> {
+  typedef PitchSet stored_type;
+  typedef PitchSet lookup_type;
+  typedef PitchSet::Hash hash;
+  static PitchSet blank() { return PitchSet{}; }
+  static bool isBlank(const PitchSet& state) { return state.empty(); }
+  static std::string toString(const PitchSet& state) { return state.toString(); }
+  static PitchSet fromString(const std::string& text) { return PitchSet::fromString(text); }
+};
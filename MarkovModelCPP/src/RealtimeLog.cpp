@@ -0,0 +1,209 @@
+/*
+  ==============================================================================
+
+    RealtimeLog.cpp
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "RealtimeLog.h"
+#include <chrono>
+#include <cstring>
+
+/** how long the background thread sleeps when there is nothing to write */
+static const auto idleWait = std::chrono::milliseconds(10);
+/** how many times a writer tries for the next slot before giving up on its record */
+static const int maxClaimAttempts = 4;
+
+static const char* levelNames[] = {"debug", "info", "warning", "error"};
+
+RealtimeLog::RealtimeLog()
+  : writePosition{0}, readPosition{0}, dropped{0}, minimum{Level::info},
+    startTime{nowMs()}, users{0}, running{false}, out{nullptr}
+{
+}
+
+RealtimeLog::~RealtimeLog()
+{
+  std::lock_guard<std::mutex> lock{threadMutex};
+  finish();
+}
+
+RealtimeLog& RealtimeLog::global()
+{
+  // never deleted: a static destructor would join the thread while a plugin's library
+  // is being unloaded, which can deadlock under the Windows loader lock
+  static RealtimeLog* log = new RealtimeLog();
+  return *log;
+}
+
+void RealtimeLog::setLevel(Level _minimum)
+{
+  minimum.store(_minimum, std::memory_order_relaxed);
+}
+
+RealtimeLog::Level RealtimeLog::getLevel() const
+{
+  return minimum.load(std::memory_order_relaxed);
+}
+
+bool RealtimeLog::write(Site& site)
+{
+  Record record;
+  if (!admit(site, record)) return false;
+  return push(record);
+}
+
+bool RealtimeLog::write(Site& site, std::int64_t value)
+{
+  Record record;
+  if (!admit(site, record)) return false;
+  record.values[0] = value;
+  record.valueCount = 1;
+  return push(record);
+}
+
+bool RealtimeLog::write(Site& site, std::int64_t first, std::int64_t second)
+{
+  Record record;
+  if (!admit(site, record)) return false;
+  record.values[0] = first;
+  record.values[1] = second;
+  record.valueCount = 2;
+  return push(record);
+}
+
+bool RealtimeLog::write(Site& site, const char* detail)
+{
+  Record record;
+  if (!admit(site, record)) return false;
+  if (detail != nullptr)
+  {
+    std::strncpy(record.detail, detail, maxDetail);
+    record.detail[maxDetail] = '\0';
+  }
+  return push(record);
+}
+
+std::uint64_t RealtimeLog::getDropped() const
+{
+  return dropped.load(std::memory_order_relaxed);
+}
+
+bool RealtimeLog::admit(Site& site, Record& record)
+{
+  if (site.level < minimum.load(std::memory_order_relaxed)) return false;
+  std::int64_t now = nowMs();
+  if (site.minIntervalMs > 0)
+  {
+    std::int64_t next = site.nextWrite.load(std::memory_order_relaxed);
+    // only one of the threads that find the interval up gets to write
+    if (now < next || !site.nextWrite.compare_exchange_strong(next, now + site.minIntervalMs, std::memory_order_relaxed))
+    {
+      site.suppressed.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+  record.time = now - startTime;
+  record.text = site.text;
+  record.suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+  record.level = site.level;
+  record.valueCount = 0;
+  record.detail[0] = '\0';
+  return true;
+}
+
+bool RealtimeLog::push(const Record& record)
+{
+  std::uint64_t position = writePosition.load(std::memory_order_relaxed);
+  for (int attempt = 0; attempt < maxClaimAttempts; ++attempt)
+  {
+    // the reader is a lap behind, so the slot is still waiting to be read
+    if (position - readPosition.load(std::memory_order_acquire) >= capacity) break;
+    if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+    {
+      Slot& slot = slots[position % capacity];
+      slot.record = record;
+      slot.ready.store(position + 1, std::memory_order_release);
+      return true;
+    }
+  }
+  dropped.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+std::size_t RealtimeLog::drain(std::string& text)
+{
+  std::lock_guard<std::mutex> lock{readMutex};
+  std::size_t count = 0;
+  std::uint64_t position = readPosition.load(std::memory_order_relaxed);
+  // stop at the first slot that is claimed but not yet written, and pick it up next time
+  while (slots[position % capacity].ready.load(std::memory_order_acquire) == position + 1)
+  {
+    Record record = slots[position % capacity].record;
+    readPosition.store(++position, std::memory_order_release);
+    char stamp[48];
+    std::snprintf(stamp, sizeof(stamp), "[%s] %lld.%03llds ", levelNames[(int) record.level],
+                  (long long) (record.time / 1000), (long long) (record.time % 1000));
+    text += stamp;
+    text += record.text;
+    for (int i = 0; i < record.valueCount; ++i) text += (i == 0 ? ": " : ", ") + std::to_string(record.values[i]);
+    if (record.detail[0] != '\0') text += std::string{": "} + record.detail;
+    if (record.suppressed > 0) text += " (" + std::to_string(record.suppressed) + " suppressed)";
+    text += "\n";
+    count ++;
+  }
+  return count;
+}
+
+void RealtimeLog::start(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock{threadMutex};
+  if (users++ > 0) return;
+  out = path.empty() ? nullptr : std::fopen(path.c_str(), "a");
+  if (out == nullptr) out = stderr;
+  running = true;
+  thread = std::thread([this]{ run(); });
+}
+
+void RealtimeLog::stop()
+{
+  std::lock_guard<std::mutex> lock{threadMutex};
+  if (users == 0 || --users > 0) return;
+  finish();
+}
+
+void RealtimeLog::finish()
+{
+  if (!thread.joinable()) return;
+  running = false;
+  thread.join();
+  std::string text;
+  drain(text);
+  std::fputs(text.c_str(), out);
+  std::fflush(out);
+  if (out != stderr) std::fclose(out);
+  out = nullptr;
+}
+
+std::int64_t RealtimeLog::nowMs()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RealtimeLog::run()
+{
+  std::string text;
+  while (running)
+  {
+    text.clear();
+    if (drain(text) == 0)
+    {
+      std::this_thread::sleep_for(idleWait);
+      continue;
+    }
+    std::fputs(text.c_str(), out);
+    std::fflush(out);
+  }
+}
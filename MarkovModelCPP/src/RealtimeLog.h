@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    RealtimeLog.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Logging that is safe from the audio thread. Writing a message copies a fixed size record
+ * into a ring, taking a bounded number of steps and never allocating, locking or doing I/O.
+ * A background thread formats the records and writes them to a file or stderr.
+ *
+ * Each call site has a level and can be rate limited, so a message that fires every block
+ * writes at most once per interval, and says how many were held back when it next gets through.
+ * When the ring is full, or other threads keep winning the race for the next slot,
+ * records are dropped and counted rather than waited for.
+ *
+ * Use it through the MARKOV_LOG macros, which keep a Site per call site.
+ */
+class RealtimeLog {
+  public:
+    enum class Level : std::uint8_t { debug, info, warning, error };
+
+    /** one place that logs: what it says, how much it matters and how often it may write */
+    struct Site {
+      constexpr Site(Level _level, const char* _text, std::uint32_t _minIntervalMs=0)
+        : level{_level}, text{_text}, minIntervalMs{_minIntervalMs}, nextWrite{0}, suppressed{0} {}
+      const Level level;
+      /** must outlive the log, e.g. a string literal */
+      const char* const text;
+      const std::uint32_t minIntervalMs;
+      /** the earliest time it may write again, in ms on the steady clock */
+      std::atomic<std::int64_t> nextWrite;
+      /** writes held back by the rate limit since the last one that got through */
+      std::atomic<std::uint32_t> suppressed;
+    };
+
+    /** records the ring holds */
+    static constexpr std::size_t capacity = 1024;
+    /** the longest detail text a record carries, longer ones are cut short */
+    static constexpr std::size_t maxDetail = 47;
+
+    RealtimeLog();
+    /** stops the background thread, writing out what is left first, however many started it */
+    ~RealtimeLog();
+    /** the log the MARKOV_LOG macros write to. It lives until the process exits and is never destroyed */
+    static RealtimeLog& global();
+
+    /** records below the sent level are ignored. info by default */
+    void setLevel(Level minimum);
+    Level getLevel() const;
+    /**
+     * write a record for the sent site, with up to two numbers or a short text.
+     * returns false if it was filtered, rate limited or dropped
+     */
+    bool write(Site& site);
+    bool write(Site& site, std::int64_t value);
+    bool write(Site& site, std::int64_t first, std::int64_t second);
+    bool write(Site& site, const char* detail);
+    /** records dropped as the ring was full or busy */
+    std::uint64_t getDropped() const;
+
+    /**
+     * start the background thread, which writes to the file at path, appending,
+     * or to stderr if path is empty or can't be opened. Calls are counted, so each user
+     * calls start and stop once. Only the first start opens the file, later paths are ignored
+     */
+    void start(const std::string& path="");
+    /** undo one start. The last stops the background thread, once it has written out what is waiting */
+    void stop();
+    /** format the records waiting in the ring onto the end of text. returns how many there were */
+    std::size_t drain(std::string& text);
+
+  private:
+    struct Record {
+      /** ms since the log was made */
+      std::int64_t time;
+      const char* text;
+      std::int64_t values[2];
+      std::uint32_t suppressed;
+      Level level;
+      std::uint8_t valueCount;
+      char detail[maxDetail + 1];
+    };
+    struct Slot {
+      /** the position this slot was last written for, plus one. 0 while empty */
+      std::atomic<std::uint64_t> ready{0};
+      Record record;
+    };
+
+    /** the level and rate checks. fills in the time and suppressed count if it may write */
+    bool admit(Site& site, Record& record);
+    /** claim a slot and publish the record into it */
+    bool push(const Record& record);
+    static std::int64_t nowMs();
+    void run();
+    /** join the background thread, write out the rest and close the file. called with threadMutex held */
+    void finish();
+
+    std::array<Slot, capacity> slots;
+    /** positions claimed by writers and taken by the reader. they only ever go up */
+    std::atomic<std::uint64_t> writePosition;
+    std::atomic<std::uint64_t> readPosition;
+    std::atomic<std::uint64_t> dropped;
+    std::atomic<Level> minimum;
+    std::int64_t startTime;
+
+    /** guards drain, so stop and the background thread can't both read */
+    std::mutex readMutex;
+    std::mutex threadMutex;
+    /** starts not yet matched by a stop, guarded by threadMutex */
+    int users;
+    std::thread thread;
+    std::atomic<bool> running;
+    std::FILE* out;
+};
+
+/** log a fixed message at a level, debug to error, no more than once every minIntervalMs. text must be a literal */
+#define MARKOV_LOG(level, text, minIntervalMs) \
+  do { static RealtimeLog::Site markovLogSite{RealtimeLog::Level::level, text, minIntervalMs}; \
+       RealtimeLog::global().write(markovLogSite); } while (false)
+
+/** as MARKOV_LOG, with a number or a short text after the message */
+#define MARKOV_LOG_VALUE(level, text, value, minIntervalMs) \
+  do { static RealtimeLog::Site markovLogSite{RealtimeLog::Level::level, text, minIntervalMs}; \
+       RealtimeLog::global().write(markovLogSite, value); } while (false)
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    RelativePitchEncoder.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "PitchSet.h"
+
+/**
+ * Turns chords into transposition invariant states for a pitch model, so a lick
+ * played in any key trains the same branch of the model.
+ *
+ * The state is still a PitchSet, which keeps the model, save format and engines as they are,
+ * but its notes mean something else:
+ * - notes 0 to 63 are the chord shape, in semitones above its bass
+ * - one note from 64 up holds the step from the previous chord's bass to this one's,
+ *   64 + 32 being no step. Steps past half an octave either way are folded in by octaves.
+ *
+ * Learning and generating each keep their own reference bass, as the player
+ * and the model move around independently.
+ */
+class RelativePitchEncoder {
+  public:
+    /** the widest step between basses that is kept, wider ones are folded in by octaves */
+    static constexpr int maxStep = 31;
+
+    RelativePitchEncoder() : inputBass{-1}, outputBass{-1} {}
+
+    /** encode a chord that was played, relative to the last one played */
+    PitchSet encode(const PitchSet& chord)
+    {
+      if (chord.empty()) return chord;
+      int reference = inputBass < 0 ? chord.lowest() : inputBass;
+      inputBass = chord.lowest();
+      return toIntervals(chord, reference);
+    }
+    /**
+     * turn a state from the model back into notes, relative to the last chord generated,
+     * or to the last one played if nothing has been generated yet
+     */
+    PitchSet decode(const PitchSet& state)
+    {
+      if (state.empty()) return state;
+      int reference = outputBass >= 0 ? outputBass : (inputBass >= 0 ? inputBass : 60);
+      PitchSet chord = fromIntervals(state, reference);
+      if (!chord.empty()) outputBass = chord.lowest();
+      return chord;
+    }
+    /** forget both references */
+    void reset()
+    {
+      inputBass = -1;
+      outputBass = -1;
+    }
+
+    /** the state for the sent chord, when the previous bass was reference */
+    static PitchSet toIntervals(const PitchSet& chord, int reference)
+    {
+      PitchSet state{};
+      if (chord.empty()) return state;
+      int bass = chord.lowest();
+      for (int note : chord)
+      {
+        if (note - bass > 63) break;
+        state.add(note - bass);
+      }
+      int step = bass - reference;
+      while (step > maxStep) step -= 12;
+      while (step < -maxStep - 1) step += 12;
+      state.add(64 + maxStep + 1 + step);
+      return state;
+    }
+    /** the chord for the sent state, moved by octaves as needed to fit the MIDI range */
+    static PitchSet fromIntervals(const PitchSet& state, int reference)
+    {
+      PitchSet chord{};
+      int step = 0;
+      int span = 0;
+      for (int note : state)
+      {
+        if (note >= 64) step = note - 64 - maxStep - 1;
+        else span = note;
+      }
+      int bass = reference + step;
+      while (bass < 0) bass += 12;
+      while (bass + span > 127 && bass >= 12) bass -= 12;
+      for (int note : state)
+      {
+        if (note >= 64) break;
+        chord.add(bass + note);
+      }
+      return chord;
+    }
+
+  private:
+    int inputBass;
+    int outputBass;
+};
@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    ScaleTables.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * The notes of the scale and the tonic chord of the 24 major and minor keys, over the whole
+ * MIDI range. The tables are built at compile time and shared, and every lookup is a read
+ * or two, so stepping through a key costs the same from any note.
+ *
+ * Keys are numbered as the plugin's key detection does them: 0 to 11 are C major to B major
+ * and 12 to 23 are C minor to B minor. Minor scales are natural minor.
+ */
+namespace ScaleTables {
+  constexpr int numKeys = 24;
+
+  /** the notes of one scale or chord, and where every MIDI note sits among them */
+  struct NoteTable {
+    /** bit n % 64 of word n / 64 is set if note n is in the table */
+    std::uint64_t mask[2];
+    /** the notes in the table, lowest first */
+    std::uint8_t notes[128];
+    int count;
+    /** how many of the notes are below each MIDI note, with below[128] being all of them */
+    std::uint8_t below[129];
+
+    constexpr bool contains(int note) const
+    {
+      return note >= 0 && note <= 127 && ((mask[note >> 6] >> (note & 63)) & 1) != 0;
+    }
+    /** the note steps notes of the table above the sent one, -1 if the table runs out first */
+    constexpr int stepUp(int note, int steps) const
+    {
+      if (note < 0 || note > 127 || steps < 1) return -1;
+      int index = below[note + 1] + steps - 1;
+      return index < count ? notes[index] : -1;
+    }
+    /** the note steps notes of the table below the sent one, -1 if the table runs out first */
+    constexpr int stepDown(int note, int steps) const
+    {
+      if (note < 0 || note > 127 || steps < 1) return -1;
+      int index = below[note] - steps;
+      return index >= 0 ? notes[index] : -1;
+    }
+  };
+
+  /** pitch classes above the root, as a bit each */
+  constexpr std::uint16_t majorScale = 1 << 0 | 1 << 2 | 1 << 4 | 1 << 5 | 1 << 7 | 1 << 9 | 1 << 11;
+  constexpr std::uint16_t minorScale = 1 << 0 | 1 << 2 | 1 << 3 | 1 << 5 | 1 << 7 | 1 << 8 | 1 << 10;
+  constexpr std::uint16_t majorChord = 1 << 0 | 1 << 4 | 1 << 7;
+  constexpr std::uint16_t minorChord = 1 << 0 | 1 << 3 | 1 << 7;
+
+  /** the pitch class of the key's root, 0 for C */
+  constexpr int root(int key)
+  {
+    return key % 12;
+  }
+  constexpr bool isMinor(int key)
+  {
+    return key >= 12;
+  }
+
+  inline constexpr const char* keyNames[numKeys] = {
+    "C Major", "C# Major", "D Major", "D# Major", "E Major", "F Major",
+    "F# Major", "G Major", "G# Major", "A Major", "A# Major", "B Major",
+    "C Minor", "C# Minor", "D Minor", "D# Minor", "E Minor", "F Minor",
+    "F# Minor", "G Minor", "G# Minor", "A Minor", "A# Minor", "B Minor"};
+  /** the key's name for display, e.g. "F# Minor", or "" if it is not a key */
+  constexpr const char* keyName(int key)
+  {
+    return key >= 0 && key < numKeys ? keyNames[key] : "";
+  }
+
+  /** every note whose pitch class above root is in pitchClasses */
+  constexpr NoteTable makeTable(int root, std::uint16_t pitchClasses)
+  {
+    NoteTable table{};
+    for (int note = 0; note < 128; ++note)
+    {
+      table.below[note] = (std::uint8_t) table.count;
+      if (((pitchClasses >> ((note - root + 12) % 12)) & 1) == 0) continue;
+      table.mask[note >> 6] |= std::uint64_t{1} << (note & 63);
+      table.notes[table.count ++] = (std::uint8_t) note;
+    }
+    table.below[128] = (std::uint8_t) table.count;
+    return table;
+  }
+
+  constexpr std::array<NoteTable, numKeys> makeTables(std::uint16_t major, std::uint16_t minor)
+  {
+    std::array<NoteTable, numKeys> tables{};
+    for (int key = 0; key < numKeys; ++key) tables[key] = makeTable(root(key), isMinor(key) ? minor : major);
+    return tables;
+  }
+
+  /** each key's scale */
+  inline constexpr std::array<NoteTable, numKeys> scales = makeTables(majorScale, minorScale);
+  /** each key's tonic triad */
+  inline constexpr std::array<NoteTable, numKeys> chords = makeTables(majorChord, minorChord);
+}
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    StateTraits.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory_resource>
+#include <functional>
+#include <cstdlib>
+
+/**
+ * Describes a type that can be used as the state of a BasicMarkovChain:
+ * how the chain stores and looks it up, what counts as a blank
+ * and how it is written to and read from a saved model.
+ *
+ * The primary template works for the unsigned integer types, e.g.
+ * velocities as std::uint8_t or times as std::uint32_t. 0 is the blank,
+ * so they save as the same text as the string states they replace.
+ * Specialise it to use any other type.
+ */
+template <typename State>
+struct StateTraits {
+  /** what the chain keeps in its symbol table */
+  typedef State stored_type;
+  /** what the symbol table is keyed on */
+  typedef State lookup_type;
+  typedef std::hash<State> hash;
+  /** the state used to pad memories before anything has been observed */
+  static State blank() { return State{0}; }
+  static bool isBlank(const State& state) { return state == 0; }
+  static std::string toString(const State& state) { return std::to_string(state); }
+  static State fromString(const std::string& text) { return static_cast<State>(std::strtoull(text.c_str(), nullptr, 10)); }
+};
+
+/** the original string states, with "0" as the blank */
+template <>
+struct StateTraits<std::string> {
+  /** lives in the chain's arena, and never moves, so the views in the symbol table stay valid */
+  typedef std::pmr::string stored_type;
+  typedef std::string_view lookup_type;
+  typedef std::hash<std::string_view> hash;
+  static std::string blank() { return "0"; }
+  static bool isBlank(const std::string& state) { return state == "0"; }
+  static std::string toString(const std::string& state) { return state; }
+  static std::string fromString(const std::string& text) { return text; }
+};
@@ -0,0 +1,406 @@
+/*
+  ==============================================================================
+
+    SuffixAutomaton.cpp
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "SuffixAutomaton.h"
+#include "PitchSet.h"
+#include "NoteEvent.h"
+#include <cstdlib>
+#include <algorithm>
+#include <ctime>
+
+template <typename Symbol>
+BasicSuffixAutomaton<Symbol>::BasicSuffixAutomaton(unsigned long _maxOrder) : last{0}, maxOrder{_maxOrder}, orderOfLastMatch{0}
+{
+  srand((int)time(NULL));
+  reset();
+}
+
+template <typename Symbol>
+BasicSuffixAutomaton<Symbol>::~BasicSuffixAutomaton()
+{
+
+}
+
+template <typename Symbol>
+void BasicSuffixAutomaton<Symbol>::reset()
+{
+  states.clear();
+  sequence.clear();
+  symbols.clear();
+  symbolIds.clear();
+  // the root represents the empty context
+  last = addState(0, -1);
+}
+
+template <typename Symbol>
+int BasicSuffixAutomaton<Symbol>::addState(int len, int link)
+{
+  states.push_back(State{len, link, 0, link, {}});
+  return (int) states.size() - 1;
+}
+
+template <typename Symbol>
+void BasicSuffixAutomaton<Symbol>::addObservation(const state_single& currentState)
+{
+  int symbol = internSymbol(currentState);
+  sequence.push_back(symbol);
+  // standard online construction: the new state represents the whole sequence
+  int cur = addState(states[last].len + 1, -1);
+  int p = last;
+  while (p != -1 && findEdge(p, symbol) == nullptr)
+  {
+    states[p].edges.push_back(Edge{symbol, cur, 0});
+    p = states[p].link;
+  }
+  if (p == -1)
+  {
+    states[cur].link = 0;
+  }
+  else
+  {
+    int q = findEdge(p, symbol)->target;
+    if (states[p].len + 1 == states[q].len)
+    {
+      states[cur].link = q;
+    }
+    else
+    {
+      // q holds strings of different lengths which have just stopped
+      // sharing their end positions - split off the shorter ones
+      int clone = addState(states[p].len + 1, states[q].link);
+      states[clone].edges = states[q].edges;
+      states[clone].count = states[q].count;
+      while (p != -1)
+      {
+        Edge* edge = findEdge(p, symbol);
+        if (edge == nullptr || edge->target != q) break;
+        edge->target = clone;
+        p = states[p].link;
+      }
+      states[q].link = clone;
+      states[q].jump = clone;
+      states[cur].link = clone;
+    }
+  }
+  states[cur].jump = states[cur].link;
+  last = cur;
+  // the new end position belongs to cur and all of its suffixes,
+  // but we only keep the counts that generateObservation can use
+  for (int state = findCounted(cur); state != -1; state = states[state].link)
+  {
+    states[state].count ++;
+  }
+}
+
+template <typename Symbol>
+Symbol BasicSuffixAutomaton<Symbol>::generateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice)
+{
+  // check for empty model
+  if (sequence.size() == 0) return traits::blank();
+  // don't allow orders beyond our own maxOrder
+  if (maxOrderWanted > (int) maxOrder) maxOrderWanted = (int) maxOrder;
+  if (maxOrderWanted < 0) maxOrderWanted = 0;
+  // walk the most recent part of the context through the automaton,
+  // keeping track of the longest suffix of it that we have seen
+  int state = 0;
+  int matched = 0;
+  unsigned long start = 0;
+  if (prevState.size() > (unsigned long) maxOrderWanted) start = prevState.size() - maxOrderWanted;
+  for (unsigned long i = start; i < prevState.size(); ++i)
+  {
+    int symbol = -1;
+    if (!traits::isBlank(prevState[i])) symbol = findSymbol(prevState[i]);
+    if (symbol == -1) // blank or unknown state - nothing before it can match
+    {
+      state = 0;
+      matched = 0;
+      continue;
+    }
+    while (state != 0 && findEdge(state, symbol) == nullptr)
+    {
+      state = states[state].link;
+      matched = states[state].len;
+    }
+    Edge* edge = findEdge(state, symbol);
+    if (edge != nullptr)
+    {
+      state = edge->target;
+      matched ++;
+    }
+  }
+  // all the contexts in one state have the same continuations, so
+  // backing off means hopping down the suffix links
+  while (true)
+  {
+    // skip states which only hold orders we are not using
+    if (state != 0)
+    {
+      int order = highestOrderBetween(states[states[state].link].len, matched);
+      if (order == -1)
+      {
+        state = states[state].link;
+        matched = states[state].len;
+        continue;
+      }
+      matched = order;
+    }
+    long total = 0;
+    for (const Edge& edge : states[state].edges) total += edgeWeight(edge);
+    // zero order ignores needChoice, as in MarkovChain
+    if (total > 0 && (!needChoice || total > 1 || state == 0))
+    {
+      long choice = rand() % total;
+      for (const Edge& edge : states[state].edges)
+      {
+        choice -= edgeWeight(edge);
+        if (choice < 0)
+        {
+          this->orderOfLastMatch = matched;
+          this->lastMatch = state_and_observation{std::to_string(state), symbols[edge.symbol]};
+          return symbols[edge.symbol];
+        }
+      }
+    }
+    if (state == 0) break;
+    state = states[state].link;
+    matched = states[state].len;
+  }
+  // everything has been removed by negative feedback
+  this->orderOfLastMatch = 0;
+  this->lastMatch = state_and_observation{"0", traits::blank()};
+  return traits::blank();
+}
+
+template <typename Symbol>
+int BasicSuffixAutomaton<Symbol>::getOrderOfLastMatch()
+{
+  return this->orderOfLastMatch;
+}
+
+template <typename Symbol>
+std::pair<std::string, Symbol> BasicSuffixAutomaton<Symbol>::getLastMatch()
+{
+  return this->lastMatch;
+}
+
+template <typename Symbol>
+void BasicSuffixAutomaton<Symbol>::removeMapping(std::string state_key, Symbol unwanted_option)
+{
+  int state = keyToState(state_key);
+  int symbol = findSymbol(unwanted_option);
+  if (state == -1 || symbol == -1) return;
+  Edge* edge = findEdge(state, symbol);
+  if (edge == nullptr) return;
+  // cancel out the count, so it stays gone until it is observed again
+  edge->bias = -states[edge->target].count;
+}
+
+template <typename Symbol>
+void BasicSuffixAutomaton<Symbol>::amplifyMapping(std::string state_key, Symbol wanted_option)
+{
+  int state = keyToState(state_key);
+  int symbol = findSymbol(wanted_option);
+  if (state == -1 || symbol == -1) return;
+  Edge* wanted = findEdge(state, symbol);
+  // can't add new edges without breaking the automaton
+  if (wanted == nullptr) return;
+  long othermappings = 0;
+  for (const Edge& edge : states[state].edges)
+  {
+    if (edge.symbol != symbol) othermappings += edgeWeight(edge);
+  }
+  // match the number of othermappings as MarkovChain does
+  wanted->bias += othermappings;
+}
+
+template <typename Symbol>
+void BasicSuffixAutomaton<Symbol>::setOrders(std::vector<unsigned long> _orders)
+{
+  std::sort(_orders.begin(), _orders.end());
+  _orders.erase(std::unique(_orders.begin(), _orders.end()), _orders.end());
+  // zero order is always available, and there are no counts above maxOrder
+  _orders.erase(std::remove_if(_orders.begin(), _orders.end(), 
+    [this](unsigned long order){ return order == 0 || order > maxOrder; }), _orders.end());
+  orders = _orders;
+}
+
+template <typename Symbol>
+std::vector<unsigned long> BasicSuffixAutomaton<Symbol>::getOrders()
+{
+  return orders;
+}
+
+template <typename Symbol>
+std::string BasicSuffixAutomaton<Symbol>::toString()
+{
+  std::string s{""};
+  if (orders.size() > 0)
+  {
+    s += "orders:" + std::to_string(orders.size()) + ",";
+    for (const unsigned long& order : orders) s += std::to_string(order) + ",";
+    s += "\n";
+  }
+  s += "sequence:";
+  s += std::to_string(sequence.size()) + ",";
+  for (const int& symbol : sequence)
+  {
+    s += traits::toString(symbols[symbol]) + ",";
+  }
+  s += "\n";
+  // state numbers are stable for a given sequence, so feedback can be saved against them
+  for (unsigned long state = 0; state < states.size(); ++state)
+  {
+    for (const Edge& edge : states[state].edges)
+    {
+      if (edge.bias == 0) continue;
+      s += "bias:" + std::to_string(state) + "," + traits::toString(symbols[edge.symbol]) + "," + std::to_string(edge.bias) + ",\n";
+    }
+  }
+  return s;
+}
+
+template <typename Symbol>
+bool BasicSuffixAutomaton<Symbol>::fromString(const std::string& savedModel)
+{
+  bool wasEmpty = sequence.size() == 0;
+  std::vector<std::string> lines = MarkovChain::tokenise(savedModel, '\n');
+  for (const std::string& line : lines)
+  {
+    if (line.rfind("orders:", 0) == 0)
+    {
+      std::vector<unsigned long> savedOrders{};
+      std::vector<std::string> parts = MarkovChain::tokenise(line.substr(7), ',');
+      for (unsigned long i=1;i<parts.size();++i){ // 1 as first is the count
+        savedOrders.push_back(std::strtoul(parts[i].c_str(), nullptr, 10));
+      }
+      setOrders(savedOrders);
+    }
+    else if (line.rfind("sequence:", 0) == 0)
+    {
+      std::vector<std::string> all_obs = MarkovChain::tokenise(line.substr(9), ',');
+      for (unsigned long i=1;i<all_obs.size();++i){ // 1 as first is the length
+        addObservation(traits::fromString(all_obs[i]));
+      }
+    }
+    else if (line.rfind("bias:", 0) == 0 && wasEmpty)
+    {
+      std::vector<std::string> parts = MarkovChain::tokenise(line.substr(5), ',');
+      if (parts.size() < 3) continue;
+      int state = keyToState(parts[0]);
+      int symbol = findSymbol(traits::fromString(parts[1]));
+      if (state == -1 || symbol == -1) continue;
+      Edge* edge = findEdge(state, symbol);
+      if (edge != nullptr) edge->bias = std::strtol(parts[2].c_str(), nullptr, 10);
+    }
+  }
+  return true;
+}
+
+template <typename Symbol>
+long BasicSuffixAutomaton<Symbol>::size()
+{
+  return sequence.size();
+}
+
+template <typename Symbol>
+float BasicSuffixAutomaton<Symbol>::getRandomness()
+{
+  return this->randomness;
+}
+
+template <typename Symbol>
+int BasicSuffixAutomaton<Symbol>::internSymbol(const state_single& symbol)
+{
+  typename std::unordered_map<Symbol, int, typename traits::hash>::iterator it = symbolIds.find(symbol);
+  if (it != symbolIds.end()) return it->second;
+  symbols.push_back(symbol);
+  symbolIds[symbol] = (int) symbols.size() - 1;
+  return (int) symbols.size() - 1;
+}
+
+template <typename Symbol>
+int BasicSuffixAutomaton<Symbol>::findSymbol(const state_single& symbol)
+{
+  typename std::unordered_map<Symbol, int, typename traits::hash>::iterator it = symbolIds.find(symbol);
+  if (it == symbolIds.end()) return -1;
+  return it->second;
+}
+
+template <typename Symbol>
+typename BasicSuffixAutomaton<Symbol>::Edge* BasicSuffixAutomaton<Symbol>::findEdge(int state, int symbol)
+{
+  // most states have only a handful of edges, so a scan beats a map
+  for (Edge& edge : states[state].edges)
+  {
+    if (edge.symbol == symbol) return &edge;
+  }
+  return nullptr;
+}
+
+template <typename Symbol>
+long BasicSuffixAutomaton<Symbol>::edgeWeight(const Edge& edge)
+{
+  long weight = states[edge.target].count + edge.bias;
+  if (weight < 0) return 0;
+  return weight;
+}
+
+template <typename Symbol>
+bool BasicSuffixAutomaton<Symbol>::isCounted(int state)
+{
+  // counted if its shortest string is short enough to be used by
+  // generateObservation: a context of maxOrder plus one continuation
+  int link = states[state].link;
+  if (link == -1) return true;
+  return (unsigned long) states[link].len + 1 <= maxOrder + 1;
+}
+
+template <typename Symbol>
+int BasicSuffixAutomaton<Symbol>::findCounted(int state)
+{
+  // states only ever stop being counted, never start, so the
+  // jump pointers can be compressed as we go
+  int found = state;
+  while (!isCounted(found)) found = states[found].jump;
+  while (state != found && !isCounted(state))
+  {
+    int next = states[state].jump;
+    states[state].jump = found;
+    state = next;
+  }
+  return found;
+}
+
+template <typename Symbol>
+int BasicSuffixAutomaton<Symbol>::keyToState(const std::string& state_key)
+{
+  char* end = nullptr;
+  long state = std::strtol(state_key.c_str(), &end, 10);
+  if (end == state_key.c_str() || state < 0 || state >= (long) states.size()) return -1;
+  return (int) state;
+}
+
+template <typename Symbol>
+int BasicSuffixAutomaton<Symbol>::highestOrderBetween(int minLen, int maxLen)
+{
+  if (maxLen <= minLen) return -1;
+  if (orders.size() == 0) return maxLen;
+  // first order above maxLen, then step back one
+  std::vector<unsigned long>::iterator it = std::upper_bound(orders.begin(), orders.end(), (unsigned long) maxLen);
+  if (it == orders.begin()) return -1;
+  --it;
+  if ((int) *it <= minLen) return -1;
+  return (int) *it;
+}
+
+template class BasicSuffixAutomaton<std::string>;
+template class BasicSuffixAutomaton<std::uint8_t>;
+template class BasicSuffixAutomaton<std::uint32_t>;
+template class BasicSuffixAutomaton<PitchSet>;
+template class BasicSuffixAutomaton<NoteEvent>;
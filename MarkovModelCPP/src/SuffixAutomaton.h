@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+    SuffixAutomaton.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "MarkovChain.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * A variable order model stored as a suffix automaton over the training sequence.
+ * Where MarkovChain stores one key per order per observation, the automaton stores
+ * at most 2n states for n observations, and every suffix of the training
+ * sequence is available as a context, whatever its length.
+ *
+ * Each state keeps the number of times its strings occur, so the continuations
+ * of a context are weighted exactly as they would be in a MarkovChain trained
+ * with addObservationAllOrders. Counts are only maintained for contexts up to maxOrder
+ * long, which keeps training at O(maxOrder) per observation.
+ * Symbol is the type of the observations, as the State of BasicMarkovChain.
+ */
+template <typename Symbol>
+class BasicSuffixAutomaton {
+  public:
+    typedef Symbol state_single;
+    typedef std::vector<Symbol> state_sequence;
+    typedef std::pair<std::string, Symbol> state_and_observation;
+    typedef StateTraits<Symbol> traits;
+
+    BasicSuffixAutomaton(unsigned long _maxOrder=100);
+    ~BasicSuffixAutomaton();
+    /**
+     * addObservation
+     * append a single observation to the training sequence. The context
+     * is whatever was added before, so there is no need to send it.
+     */
+    void addObservation(const state_single& currentState);
+    /**
+     * generateObservation: generate a new observation. Finds the longest suffix of prevState
+     * (up to maxOrderWanted long) that occurs in the training sequence and samples one
+     * of its continuations. If there is none, or needChoice is set and there is only one
+     * continuation, it backs off to shorter contexts, down to zero order.
+     * Remembers the order it used into this->orderOfLastMatch
+     * @return a state sampled from the model or a blank if the model is empty
+     */
+    state_single generateObservation(const state_sequence& prevState, int maxOrderWanted, bool needChoice=false);
+    /**
+     * setOrders: only match contexts of the sent orders when generating. Every state
+     * covers a range of context lengths, so this just changes where backing off stops.
+     * Orders above the maxOrder sent to the constructor are dropped, as there are no
+     * counts for them. An empty list goes back to using all orders.
+     */
+    void setOrders(std::vector<unsigned long> orders);
+    /** the orders set with setOrders - empty if all orders are in use */
+    std::vector<unsigned long> getOrders();
+    /**return the order of the last match generated from generateObservation
+     */
+    int getOrderOfLastMatch();
+    /**
+     * returns the key-value that was used to generate the last observation.
+     * The key identifies a state in the automaton, it can be sent back to
+     * removeMapping and amplifyMapping
+     */
+    state_and_observation getLastMatch();
+    /**
+     * stop the sent observation from following the context identified by state_key
+     */
+    void removeMapping(std::string state_key, state_single unwanted_option);
+    /**
+     * make the sent observation as likely as all the other options following state_key put together
+     */
+    void amplifyMapping(std::string state_key, state_single wanted_option);
+    /**
+     * toString: the order set if there is one, the training sequence plus any feedback, e.g.:
+     * orders:2,1,3,\n
+     * sequence:3,a,b,c,\n
+     * bias:2,c,-1,\n
+     */
+    std::string toString();
+    /**
+     * fromString: append the saved sequence to the automaton. Feedback
+     * is only restored if the automaton was empty to start with.
+     */
+    bool fromString(const std::string& savedModel);
+    /** wipe the automaton */
+    void reset();
+    /** return number of observations in the training sequence*/
+    long size();
+
+    float randomness = 0.0f;
+
+    float getRandomness();
+  private:
+    struct Edge {
+      int symbol;
+      int target;
+      /** feedback adjustment to the weight of this edge */
+      long bias;
+    };
+    struct State {
+      /** length of the longest string in this state */
+      int len;
+      /** suffix link */
+      int link;
+      /** how many times the strings in this state occur in the training sequence */
+      long count;
+      /** shortcut towards the first ancestor whose count is maintained */
+      int jump;
+      std::vector<Edge> edges;
+    };
+    /** return the id of the sent symbol, adding it if needed */
+    int internSymbol(const state_single& symbol);
+    /** return the id of the sent symbol or -1 if we have never seen it */
+    int findSymbol(const state_single& symbol);
+    /** returns the edge leaving state on the sent symbol or nullptr */
+    Edge* findEdge(int state, int symbol);
+    /** count of the edge target, adjusted by the feedback bias */
+    long edgeWeight(const Edge& edge);
+    /** true if the occurrence count of the sent state is kept up to date */
+    bool isCounted(int state);
+    /** returns the nearest ancestor (or the state itself) which is counted */
+    int findCounted(int state);
+    /** adds a state and returns its index */
+    int addState(int len, int link);
+    /** convert a key from getLastMatch back into a state index, -1 if invalid */
+    int keyToState(const std::string& state_key);
+    /** highest order in use which is no more than maxLen and above minLen, -1 if there is none */
+    int highestOrderBetween(int minLen, int maxLen);
+
+    std::vector<State> states;
+    /** the training sequence as symbol ids */
+    std::vector<int> sequence;
+    std::vector<state_single> symbols;
+    std::unordered_map<Symbol, int, typename traits::hash> symbolIds;
+    /** state representing the whole training sequence */
+    int last;
+    unsigned long maxOrder;
+    /** sorted list of orders in use, empty for all of them */
+    std::vector<unsigned long> orders;
+    unsigned long orderOfLastMatch;
+    state_and_observation lastMatch;
+};
+
+typedef BasicSuffixAutomaton<std::string> SuffixAutomaton;
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    TimeQuantiser.cpp
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "TimeQuantiser.h"
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+TimeQuantiser::TimeQuantiser(Mode _mode, double _sampleRate) : mode{_mode}, sampleRate{_sampleRate}, bpm{120.0}
+{
+  reset();
+}
+
+void TimeQuantiser::setMode(Mode _mode)
+{
+  if (_mode == mode) return;
+  mode = _mode;
+  reset();
+}
+
+TimeQuantiser::Mode TimeQuantiser::getMode() const
+{
+  return mode;
+}
+
+void TimeQuantiser::setSampleRate(double _sampleRate)
+{
+  if (_sampleRate > 0) sampleRate = _sampleRate;
+}
+
+void TimeQuantiser::setTempo(double _bpm)
+{
+  if (_bpm > 0) bpm = _bpm;
+}
+
+double TimeQuantiser::getTempo() const
+{
+  return bpm;
+}
+
+std::uint32_t TimeQuantiser::quantise(unsigned long samples)
+{
+  double seconds = samples / sampleRate;
+  long bin = std::lround(binPosition(seconds));
+  bin = std::clamp(bin, 1l, (long) maxBin);
+  ratioSums[bin] += seconds / binCentre((std::uint32_t) bin);
+  ratioCounts[bin] ++;
+  return (std::uint32_t) bin;
+}
+
+unsigned long TimeQuantiser::dequantise(std::uint32_t bin) const
+{
+  if (bin == 0) return 0;
+  if (bin > maxBin) bin = maxBin;
+  double ratio = ratioCounts[bin] > 0 ? ratioSums[bin] / ratioCounts[bin] : 1.0;
+  return (unsigned long) std::lround(binCentre(bin) * ratio * sampleRate);
+}
+
+void TimeQuantiser::reset()
+{
+  ratioSums.assign(maxBin + 1, 0.0);
+  ratioCounts.assign(maxBin + 1, 0);
+}
+
+std::string TimeQuantiser::toString() const
+{
+  std::string s = mode == Mode::tempoGrid ? "grid," : "log,";
+  for (std::uint32_t bin = 1; bin <= maxBin; ++bin)
+  {
+    if (ratioCounts[bin] == 0) continue;
+    s += std::to_string(bin) + ":" + std::to_string(ratioSums[bin] / ratioCounts[bin]) + ":" + std::to_string(ratioCounts[bin]) + ",";
+  }
+  return s;
+}
+
+bool TimeQuantiser::fromString(const std::string& saved)
+{
+  std::size_t comma = saved.find(',');
+  if (comma == std::string::npos) return false;
+  std::string savedMode = saved.substr(0, comma);
+  if (savedMode != "grid" && savedMode != "log") return false;
+  mode = savedMode == "grid" ? Mode::tempoGrid : Mode::logarithmic;
+  reset();
+  std::size_t start = comma + 1;
+  while (start < saved.size())
+  {
+    char* end;
+    unsigned long bin = std::strtoul(saved.c_str() + start, &end, 10);
+    if (*end != ':') break;
+    double ratio = std::strtod(end + 1, &end);
+    if (*end != ':') break;
+    unsigned long count = std::strtoul(end + 1, &end, 10);
+    if (bin >= 1 && bin <= maxBin)
+    {
+      ratioSums[bin] = ratio * count;
+      ratioCounts[bin] = (std::uint32_t) count;
+    }
+    start = (end - saved.c_str()) + 1;
+  }
+  return true;
+}
+
+double TimeQuantiser::binPosition(double seconds) const
+{
+  if (mode == Mode::tempoGrid) return seconds * (bpm / 60.0) * divisionsPerBeat;
+  if (seconds <= minSeconds) return 1.0;
+  return 1.0 + std::log2(seconds / minSeconds) * binsPerOctave;
+}
+
+double TimeQuantiser::binCentre(std::uint32_t bin) const
+{
+  if (mode == Mode::tempoGrid) return (bin / divisionsPerBeat) * (60.0 / bpm);
+  return minSeconds * std::exp2((bin - 1) / binsPerOctave);
+}
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    TimeQuantiser.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Maps times in samples, such as inter onset intervals or note lengths, to a small alphabet
+ * of bins for a markov model, and bins back to times for generation. The bins do not depend
+ * on the sample rate, so a model trained at 44.1k plays the same at 96k.
+ *
+ * There are two ways of binning:
+ * - logarithmic: binsPerOctave bins for each doubling of the time, from minSeconds up,
+ *   so short times are told apart more finely than long ones
+ * - tempoGrid: multiples of 1/divisionsPerBeat of a beat at the current tempo. 12 divisions
+ *   hold both sixteenths and triplets
+ *
+ * Each bin also remembers where in the bin the times it was sent fell on average,
+ * so generation gets back the player's feel rather than the bin centre.
+ * Bins start from 1, as 0 is the blank state for the models.
+ */
+class TimeQuantiser {
+  public:
+    enum class Mode { logarithmic, tempoGrid };
+
+    /** the largest bin, so any mode fits the dense model engine */
+    static constexpr std::uint32_t maxBin = 96;
+    static constexpr double minSeconds = 0.02;
+    static constexpr double binsPerOctave = 6.0;
+    static constexpr double divisionsPerBeat = 12.0;
+
+    TimeQuantiser(Mode mode=Mode::logarithmic, double sampleRate=44100.0);
+    /** changing mode changes what the bins mean, so it forgets the per bin timings */
+    void setMode(Mode mode);
+    Mode getMode() const;
+    void setSampleRate(double sampleRate);
+    /** beats per minute for the tempoGrid mode, ignored if not positive */
+    void setTempo(double bpm);
+    double getTempo() const;
+    /** the bin for a time in samples, between 1 and maxBin. Also updates that bin's average */
+    std::uint32_t quantise(unsigned long samples);
+    /** the time in samples to use for a bin, 0 for the blank */
+    unsigned long dequantise(std::uint32_t bin) const;
+    /** forget the per bin timings */
+    void reset();
+    /** writes the mode and the per bin timings */
+    std::string toString() const;
+    /** reads what toString wrote. returns false and leaves things as they were if it can't */
+    bool fromString(const std::string& saved);
+
+  private:
+    /** the bin a time in the current unit falls into, without the clamp to the alphabet */
+    double binPosition(double seconds) const;
+    /** the time in seconds at the centre of a bin */
+    double binCentre(std::uint32_t bin) const;
+
+    Mode mode;
+    double sampleRate;
+    double bpm;
+    /** sum of the times sent to each bin, as a fraction of its centre, and how many there were */
+    std::vector<double> ratioSums;
+    std::vector<std::uint32_t> ratioCounts;
+};
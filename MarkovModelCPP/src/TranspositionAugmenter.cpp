@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    TranspositionAugmenter.cpp
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "TranspositionAugmenter.h"
+#include <chrono>
+
+/** how long an idle worker sleeps before looking at its queue again */
+static const auto idleWait = std::chrono::milliseconds(2);
+
+TranspositionAugmenter::TranspositionAugmenter(JointEventModel& _model, std::size_t workerCount)
+  : model{_model}, running{true}
+{
+  if (workerCount == 0) workerCount = 1;
+  for (std::size_t i = 0; i < workerCount; ++i) workers.push_back(std::make_unique<Worker>());
+  setTranspositions({-6, -5, -4, -3, -2, -1, 1, 2, 3, 4, 5});
+  for (auto& worker : workers)
+  {
+    Worker* w = worker.get();
+    w->thread = std::thread([this, w]{ run(*w); });
+  }
+}
+
+TranspositionAugmenter::~TranspositionAugmenter()
+{
+  running = false;
+  for (auto& worker : workers) worker->thread.join();
+}
+
+void TranspositionAugmenter::setTranspositions(const std::vector<int>& semitones)
+{
+  std::lock_guard<std::mutex> lock{transpositionMutex};
+  for (auto& worker : workers) worker->transpositions.clear();
+  std::size_t next = 0;
+  for (int s : semitones)
+  {
+    if (s == 0) continue;
+    workers[next % workers.size()]->transpositions.push_back(s);
+    next ++;
+  }
+}
+
+std::vector<int> TranspositionAugmenter::getTranspositions()
+{
+  std::lock_guard<std::mutex> lock{transpositionMutex};
+  std::vector<int> semitones{};
+  for (auto& worker : workers)
+    semitones.insert(semitones.end(), worker->transpositions.begin(), worker->transpositions.end());
+  return semitones;
+}
+
+bool TranspositionAugmenter::push(const NoteEvent& event)
+{
+  // all or nothing, so the workers see the same events
+  for (auto& worker : workers)
+    if (worker->written.load(std::memory_order_relaxed) - worker->done.load(std::memory_order_acquire) >= queueSize) return false;
+  for (auto& worker : workers)
+  {
+    std::size_t written = worker->written.load(std::memory_order_relaxed);
+    worker->queue[written % queueSize] = event;
+    worker->written.store(written + 1, std::memory_order_release);
+  }
+  return true;
+}
+
+void TranspositionAugmenter::flush()
+{
+  for (auto& worker : workers)
+  {
+    std::size_t target = worker->written.load(std::memory_order_acquire);
+    while (worker->done.load(std::memory_order_acquire) < target) std::this_thread::sleep_for(idleWait);
+  }
+}
+
+void TranspositionAugmenter::run(Worker& worker)
+{
+  std::vector<int> transpositions{};
+  while (running)
+  {
+    std::size_t done = worker.done.load(std::memory_order_relaxed);
+    if (done == worker.written.load(std::memory_order_acquire))
+    {
+      std::this_thread::sleep_for(idleWait);
+      continue;
+    }
+    NoteEvent event = worker.queue[done % queueSize];
+    {
+      std::lock_guard<std::mutex> lock{transpositionMutex};
+      transpositions = worker.transpositions;
+    }
+    for (int s : transpositions) model.putTransposedEvent(event, s);
+    worker.done.store(done + 1, std::memory_order_release);
+  }
+}
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    TranspositionAugmenter.h
+    Created: 19 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "JointEventModel.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Trains a JointEventModel on copies of each event moved into other keys, so what is
+ * played in one key can come back in any of them. The copies are trained by a small pool
+ * of worker threads: push only writes the event into each worker's queue, so it is safe to
+ * call from the audio thread. Each transposition belongs to one worker, so its copies are
+ * learnt in the order they were played.
+ */
+class TranspositionAugmenter {
+  public:
+    /** events waiting per worker. push drops events when a worker falls this far behind */
+    static constexpr std::size_t queueSize = 256;
+
+    /** starts the workers, with all the other 11 keys, from 6 down to 5 up */
+    TranspositionAugmenter(JointEventModel& model, std::size_t workerCount=2);
+    /** stops the workers. Events still queued are not learnt */
+    ~TranspositionAugmenter();
+    /** the semitones to move each event by. 0 is ignored, the event itself is learnt by the caller */
+    void setTranspositions(const std::vector<int>& semitones);
+    std::vector<int> getTranspositions();
+    /** queue an event for the workers. returns false if it was dropped as a queue was full */
+    bool push(const NoteEvent& event);
+    /** wait until the workers have learnt everything pushed so far */
+    void flush();
+
+  private:
+    struct Worker {
+      /** single producer, single consumer ring. written and done only ever go up */
+      std::array<NoteEvent, queueSize> queue;
+      std::atomic<std::size_t> written{0};
+      std::atomic<std::size_t> done{0};
+      /** this worker's share of the transpositions, guarded by transpositionMutex */
+      std::vector<int> transpositions;
+      std::thread thread;
+    };
+    void run(Worker& worker);
+
+    JointEventModel& model;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex transpositionMutex;
+    std::atomic<bool> running;
+};